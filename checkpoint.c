@@ -0,0 +1,98 @@
+#include "checkpoint.h"
+#include "record_format.h"
+
+_Static_assert(CHECKPOINT_ADDRESS % EEPROM_PAGE_SIZE == 0, "Checkpoint slots must start on a page boundary");
+_Static_assert(CHECKPOINT_SLOT_SIZE <= EEPROM_PAGE_SIZE, "A checkpoint slot must fit in one page");
+
+static uint16_t checkpoint_sequence = 0;                // Sequence of the newest checkpoint
+static uint8_t checkpoint_slot = CHECKPOINT_SLOTS - 1;  // Slot holding the newest checkpoint
+static uint8_t checkpoint_pending = 0;                  // Saves since the newest checkpoint
+
+// Reads the checkpoint area and returns the recorded sector, or SECTOR_NONE if there is none
+static uint8_t checkpoint_read(const struct_i2c_handle *i2c)
+{
+    uint8_t slots[CHECKPOINT_SLOTS * CHECKPOINT_SLOT_SIZE];
+    struct_eeprom_op_t ops[CHECKPOINT_SLOTS];
+    uint8_t sector = SECTOR_NONE;
+
+    for (uint8_t i = 0; i < CHECKPOINT_SLOTS; i++)
+    {
+        ops[i] = (struct_eeprom_op_t){ EEPROM_OP_READ, CHECKPOINT_ADDRESS + i * EEPROM_PAGE_SIZE, &slots[i * CHECKPOINT_SLOT_SIZE], CHECKPOINT_SLOT_SIZE };
+    }
+
+    if (eeprom_bus_batch(i2c, ops, CHECKPOINT_SLOTS) != CHECKPOINT_SLOTS)
+    {
+        return SECTOR_NONE;
+    }
+
+    for (uint8_t i = 0; i < CHECKPOINT_SLOTS; i++)
+    {
+        const uint8_t *slot = &slots[i * CHECKPOINT_SLOT_SIZE];
+        uint16_t sequence = le16_load(&slot[0]);
+        uint16_t crc = le16_load(&slot[3]);
+
+        if (slot[2] >= sector_count || calculate_crc16(slot, 3) != crc)
+        {
+            continue;
+        }
+
+        if (sector == SECTOR_NONE || (int16_t)(sequence - checkpoint_sequence) > 0)
+        {
+            sector = slot[2];
+            checkpoint_sequence = sequence;
+            checkpoint_slot = i;
+        }
+    }
+
+    return sector;
+}
+
+static void checkpoint_write(const struct_i2c_handle *i2c, uint8_t sector)
+{
+    uint8_t slot[CHECKPOINT_SLOT_SIZE];
+
+    checkpoint_sequence++;
+    checkpoint_slot = (checkpoint_slot + 1) % CHECKPOINT_SLOTS;
+
+    le16_store(&slot[0], checkpoint_sequence);
+    slot[2] = sector;
+    le16_store(&slot[3], calculate_crc16(slot, 3));
+
+    // A lost checkpoint only lengthens the next boot scan, so failures are not retried here
+    eeprom_bus_write(i2c, CHECKPOINT_ADDRESS + checkpoint_slot * EEPROM_PAGE_SIZE, slot, sizeof(slot));
+    checkpoint_pending = 0;
+}
+
+uint8_t checkpoint_sector_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size)
+{
+    uint8_t hint = checkpoint_read(i2c);
+    uint8_t window = (CHECKPOINT_INTERVAL + 1 < sector_count) ? CHECKPOINT_INTERVAL + 1 : sector_count;
+
+    if (hint != SECTOR_NONE)
+    {
+        uint8_t active_sector = eeprom_sector_load_from(i2c, buffer, size, hint, window);
+
+        if (active_sector < sector_count)
+        {
+            // Saves already made since the checkpoint count towards the next one
+            checkpoint_pending = (uint8_t)((active_sector + sector_count - hint) % sector_count);
+            return active_sector;
+        }
+    }
+
+    // No checkpoint or a stale one, fall back to the full scan
+    checkpoint_pending = CHECKPOINT_INTERVAL;
+    return eeprom_sector_load(i2c, buffer, size);
+}
+
+uint8_t checkpoint_sector_write(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector)
+{
+    current_sector = eeprom_sector_write(i2c, buffer, size, current_sector);
+
+    if (++checkpoint_pending >= CHECKPOINT_INTERVAL)
+    {
+        checkpoint_write(i2c, current_sector);
+    }
+
+    return current_sector;
+}
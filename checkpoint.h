@@ -0,0 +1,64 @@
+/**
+ * @file checkpoint.h
+ * @brief Periodic Write Pointer Checkpoint
+ *
+ * Scanning every sector at boot costs bus time proportional to the number of sectors.
+ * This module records the active sector in a rotating checkpoint area every
+ * `CHECKPOINT_INTERVAL` saves. At boot the checkpoint slots are read in one batch and
+ * the scan starts at the recorded sector, inspecting at most `CHECKPOINT_INTERVAL + 1`
+ * sectors before falling back to a full `eeprom_sector_load()`.
+ *
+ * Each slot lives in a page of its own, so a checkpoint page is written once every
+ * `CHECKPOINT_SLOTS * CHECKPOINT_INTERVAL` saves, while every sector takes about three
+ * page writes per `sector_count` saves. The checkpoint pages therefore wear no faster
+ * than the sectors as long as `sector_count` stays below
+ * `3 * CHECKPOINT_SLOTS * CHECKPOINT_INTERVAL` (192 with the defaults); raise either
+ * setting for larger rings.
+ *
+ * @note Configure `CHECKPOINT_ADDRESS`, `CHECKPOINT_SLOTS` and `CHECKPOINT_INTERVAL`
+ *       in `config.h`.
+ *
+ * Usage:
+ * - Call `checkpoint_sector_load()` instead of `eeprom_sector_load()`.
+ * - Call `checkpoint_sector_write()` instead of `eeprom_sector_write()`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "wear_levelling.h"
+
+/**
+ * Checkpoint Slot Layout, slot i at `CHECKPOINT_ADDRESS + i * EEPROM_PAGE_SIZE`:
+ * +----------+--------+-------+
+ * | Sequence | Sector | CRC16 |
+ * +----------+--------+-------+
+ */
+
+#define CHECKPOINT_SLOT_SIZE    5   ///< Sequence (2) + sector (1) + CRC (2)
+
+/**
+ * @brief Loads the most recent valid state starting at the checkpointed sector.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the buffer where the state will be loaded.
+ * @param size Size of the state structure.
+ * @return The active sector index.
+ */
+uint8_t checkpoint_sector_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Writes a new state and refreshes the checkpoint every `CHECKPOINT_INTERVAL` saves.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the data to be written.
+ * @param size Size of the data in bytes.
+ * @param current_sector Index of the currently active sector.
+ * @return The new active sector index.
+ */
+uint8_t checkpoint_sector_write(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector);
+
+#endif // CHECKPOINT_H
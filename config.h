@@ -5,7 +5,15 @@
 #include <stdint.h>
 
 // User-defined sector information
-#define NUMBER_OF_SECTORS 4             // Total number of sectors to divide the read-write cycles
+#define NUMBER_OF_SECTORS 4             // Total number of sectors to divide the read-write cycles, at least 3, the most layout_plan() may use
+#define SECTOR_MAP_ADDRESS 0x0000       // Start of the default sector map, used unless layout_plan() is called
+#define SECTOR_MAP_SIZE   0x4000        // Size of the default sector map, split evenly between the sectors
+#define SECTOR_DEVICES    2             // EEPROMs using the sector map, each through its own I2C handle
+
+// EEPROM geometry
+#define EEPROM_PAGE_SIZE  64            // Page write buffer size of the device in bytes (e.g. 64 for 24C256)
+#define EEPROM_CAPACITY   0x8000        // Device size in bytes (e.g. 32768 for 24C256), used by layout_plan()
+#define EEPROM_BLANK_VALUE 0xFF         // Value read back from an erased (factory fresh) EEPROM cell
 
 // Define I2C structure (Modify this to fit your I2C implementation)
 typedef struct {
@@ -16,15 +24,163 @@ typedef struct {
 void eeprom_write(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size);
 void eeprom_read(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size);
 
+// Result of a bus operation
+typedef enum {
+    EEPROM_OK = 0,                      // Transfer completed
+    EEPROM_ERR_NACK,                    // Device did not acknowledge (busy or absent)
+    EEPROM_ERR_ARBITRATION,             // Arbitration lost to another master
+    EEPROM_ERR_BUS,                     // Bus stuck or other controller error
+    EEPROM_ERR_TIMEOUT,                 // Operation did not complete in time
+    EEPROM_BUSY                         // Asynchronous transfer still in progress
+} eeprom_status_t;
+
+// Bus error handling (eeprom_bus.c)
+#define EEPROM_BUS_RETRY          0     // 1 to use the status-returning HAL hooks below with bounded retries
+#define EEPROM_RETRY_ATTEMPTS     4     // Failed attempts per transfer, NACKs excluded as they are polled until the timeout
+#define EEPROM_RETRY_TIMEOUT_US   20000 // Time budget per transfer including retries, bounds worst-case latency
+#define EEPROM_RECOVERY_PULSES    9     // SCL pulses issued to release a slave holding SDA low
+
+#if EEPROM_BUS_RETRY
+// Status-returning EEPROM API (Modify these for your EEPROM API)
+eeprom_status_t eeprom_write_status(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size);
+eeprom_status_t eeprom_read_status(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size);
+void eeprom_bus_recover(const struct_i2c_handle *i2c, uint8_t pulses);  // Clock SCL, then issue a STOP
+#endif
+
+// Batched bus operations (eeprom_bus.c)
+#define EEPROM_BATCH              0     // 1 to hand known transfer sequences to eeprom_submit_batch()
+
+// Type of a batched operation
+typedef enum {
+    EEPROM_OP_READ = 0,                 // Read `size` bytes into `data`
+    EEPROM_OP_WRITE,                    // Write `size` bytes from `data`, split at page boundaries as by eeprom_write()
+    EEPROM_OP_POLL                      // ACK poll until the write cycle of the previous write has ended
+} eeprom_op_type_t;
+
+// Batched operation
+typedef struct {
+    eeprom_op_type_t type;
+    uint16_t address;
+    uint8_t *data;                      // Source of a write, destination of a read, unused by a poll
+    uint32_t size;
+} struct_eeprom_op_t;
+
+#if EEPROM_BATCH
+// Runs the operations in order, e.g. chained by DMA, and stops at the first failure. Returns the number completed.
+uint8_t eeprom_submit_batch(const struct_i2c_handle *i2c, const struct_eeprom_op_t *ops, uint8_t count);
+#endif
+
+// Differential sector writes (wear_levelling.c, needs record_diff.c)
+#define SECTOR_DIFF_WRITE         0     // 1 to read the next sector first and only rewrite the pages that differ
+
+// Latency histograms (latency_hist.c)
+#define LATENCY_HIST              0     // 1 to record load, save, clear and recovery latency
+#define LATENCY_HIST_SUB_BITS     3     // 2^N buckets per power of two, relative error below 1 / 2^N
+#define LATENCY_HIST_RANGE_BITS   18    // Largest tracked latency is 2^N - 1 us, longer ones land in the last bucket
+
+#if EEPROM_BUS_RETRY || LATENCY_HIST
+uint32_t eeprom_time_us(void);                                          // Free-running microsecond timestamp
+#endif
 
 // CRC calculation function (User must implement it)
 uint16_t calculate_crc16(const uint8_t *data, uint32_t length);
 
+// Packing attribute for records stored on the device (Modify for your compiler)
+#define WL_PACKED __attribute__((packed))
+
 // Define the structure of the system state (Modify as needed)
-typedef struct {
+// Stored as-is on the device, so it must be packed and end with the CRC (little-endian, see record_format.h)
+typedef struct WL_PACKED {
     uint8_t data[64]; // Example payload
     uint16_t crc;     // CRC for data integrity
 } struct_data_t;
 
+// CRC parameters used by crc16_incremental.c, must match calculate_crc16()
+#define CRC16_POLYNOMIAL       0x1021   // Generator polynomial in normal (MSB first) form, e.g. 0x1021 CCITT, 0x8005 Modbus
+#define CRC16_REFLECTED        0        // 1 if calculate_crc16() processes bits LSB first (Modbus, ARC, X.25)
+
+// Delta journal configuration (delta_journal.c)
+#define JOURNAL_ADDRESS        0x4000   // Start of the journal region, must not overlap the sectors
+#define JOURNAL_SIZE           0x0400   // Size of the journal region in bytes
+#define JOURNAL_MAX_ENTRIES    32       // Deltas replayed at load before a new snapshot is forced
+#define JOURNAL_MAX_DELTA      32       // Largest payload carried by a single delta entry, at most 127
+
+// Small record packing configuration (record_pack.c)
+#define PACK_ADDRESS           0x4400   // Start of the pack ring, must be aligned to EEPROM_PAGE_SIZE
+#define PACK_PAGES             8        // Number of pages in the pack ring
+#define PACK_MAX_RECORDS       8        // Maximum number of small records that can be registered
+
+// Write pointer checkpoint configuration (checkpoint.c)
+#define CHECKPOINT_ADDRESS     0x5D40   // Start of the checkpoint area, page aligned, CHECKPOINT_SLOTS pages
+#define CHECKPOINT_SLOTS       8        // Rotating checkpoint slots, 5 bytes each in a page of their own
+#define CHECKPOINT_INTERVAL    8        // Saves between checkpoints (K), boot scans at most K + 1 sectors
+
+// Per-caller write attribution (write_attribution.c)
+#define ATTRIBUTION_ADDRESS    0x4640   // Start of the two attribution slots, must not overlap other regions
+#define ATTRIBUTION_TAGS       8        // Caller tags counted separately, larger tags count towards the last one
+#define ATTRIBUTION_INTERVAL   16       // Tagged saves between persisting the counters
+
+// Tiered storage with an FRAM front tier (tiered_storage.c)
+#define TIER_FRAM_ADDRESS      0x0000   // Start of the two FRAM slots, each record size + 6 bytes
+#define TIER_DESTAGE_INTERVAL  64       // FRAM saves between destages to the EEPROM, 0 to destage only on request
+
+// FRAM read/write function signatures (Modify these for your FRAM API)
+void fram_write(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size);
+void fram_read(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size);
+
+// Persistent FIFO queue (persistent_queue.c)
+#define QUEUE_ADDRESS          0x4800   // Start of the entry ring
+#define QUEUE_ENTRIES          64       // Entries in the ring, at most 32767
+#define QUEUE_ENTRY_SIZE       28       // Payload bytes per entry, + 4 should divide EEPROM_PAGE_SIZE
+#define QUEUE_ACK_ADDRESS      0x5000   // Start of the acknowledgement slots, page aligned, QUEUE_ACK_SLOTS pages
+#define QUEUE_ACK_SLOTS        4        // Rotating acknowledgement slots, 4 bytes each in a page of their own
+
+// Time-series sample region (time_series.c)
+#define TS_ADDRESS             0x5100   // Start of the page ring, must be aligned to EEPROM_PAGE_SIZE
+#define TS_PAGES               16       // Pages in the ring, at most 32767
+#define TS_SAMPLE_SIZE         8        // Payload bytes per sample, at most EEPROM_PAGE_SIZE - 14
+
+// On-device hash table (hash_table.c)
+#define HASH_ADDRESS           0x5500   // Start of the table, page aligned, HASH_TABLE_SIZE bytes
+#define HASH_BUCKETS           32       // Buckets, each holding one key, keep the load factor below about 0.7
+#define HASH_SLOTS             4        // Rotating version slots per bucket, each in its own page, spreading the wear of updates
+#define HASH_VALUE_SIZE        10       // Value bytes per key
+
+// Read-optimized sorted table (sorted_table.c)
+#define TABLE_ADDRESS          0x6000   // Start of the table, written once by table_write()
+#define TABLE_VALUE_SIZE       4        // Value bytes per key
+#define TABLE_BLOCK_ENTRIES    8        // Entries per CRC-protected block, the unit of reads and caching
+#define TABLE_CACHE_BLOCKS     2        // Most recently used blocks kept in RAM
+
+// Background scrubber (scrubber.c)
+#define SCRUB_ADDRESS          0x5D00   // Start of the two write time stamp slots, 6 bytes each
+#define SCRUB_CHUNK            16       // Bytes read per scrub step, bounds the bus time of a step
+#define SCRUB_MAX_AGE_S        157680000ul  // Refresh a record not rewritten for this long (5 years), 0 to disable
+#define SCRUB_JOURNAL          0        // 1 if the record is a delta journal snapshot, refreshed by journal_compact() instead of scrub_step()
+
+#if SCRUB_MAX_AGE_S
+uint32_t eeprom_rtc_seconds(void);                                      // Real-time clock in seconds, kept across resets
+#endif
+
+// Save durability (durability.c)
+#define DURABILITY_VERIFY_ATTEMPTS  2   // Sectors tried by a verified save before it fails, below NUMBER_OF_SECTORS
+
+// Concurrent load from several buses (multi_bus.c)
+#define MULTI_BUS_MAX               2   // I2C controllers loaded concurrently, each with its own EEPROM, at most SECTOR_DEVICES
+#define EEPROM_ASYNC_READ           0   // 1 to overlap the buses with the asynchronous read hooks below, 0 to read them in turn
+
+#if EEPROM_ASYNC_READ
+// Asynchronous EEPROM read (Modify these for your EEPROM API, e.g. interrupt or DMA driven)
+eeprom_status_t eeprom_read_start(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size);  // Starts a read and returns at once
+eeprom_status_t eeprom_read_done(const struct_i2c_handle *i2c);                                                    // EEPROM_BUSY until the read started on this bus ends
+#endif
+
+// Record schema (record_schema.c)
+// FIELD(type, name, dimensions, since)           -> field present in the current version
+// RETIRED(name, size, since, until)              -> field removed in version `until`, kept to upgrade older records
+// Fields are stored packed in list order. Add fields with `since` = the bumped RECORD_SCHEMA_VERSION, never reorder.
+#define RECORD_SCHEMA_VERSION  1
+#define RECORD_SCHEMA(FIELD, RETIRED) \
+    FIELD(uint8_t, data, [64], 1)
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "crc16_incremental.h"
+
+#define CRC16_SHIFT_TABLE_SIZE  32                  ///< Covers shifts of up to 2^32 - 1 bytes
+
+#if CRC16_REFLECTED
+#define CRC16_ONE               0x8000              ///< The polynomial 1 in reflected form
+
+// Generator polynomial with its bits in reflected order
+#define CRC16_BIT(i)            (((CRC16_POLYNOMIAL >> (i)) & 1) << (15 - (i)))
+#define CRC16_POLY              (CRC16_BIT(0) | CRC16_BIT(1) | CRC16_BIT(2) | CRC16_BIT(3) | CRC16_BIT(4) |     \
+                                 CRC16_BIT(5) | CRC16_BIT(6) | CRC16_BIT(7) | CRC16_BIT(8) | CRC16_BIT(9) |     \
+                                 CRC16_BIT(10) | CRC16_BIT(11) | CRC16_BIT(12) | CRC16_BIT(13) | CRC16_BIT(14) | \
+                                 CRC16_BIT(15))
+
+// Multiplies by x, and reads the coefficient of x^i
+#define CRC16_MUL_X(v)          (((v) >> 1) ^ (((v) & 1) * CRC16_POLY))
+#define CRC16_COEF(v, i)        (((v) >> (15 - (i))) & 1)
+#else
+#define CRC16_ONE               0x0001              ///< The polynomial 1 in normal form
+#define CRC16_POLY              CRC16_POLYNOMIAL
+
+#define CRC16_MUL_X(v)          ((((v) << 1) & 0xFFFF) ^ (((v) >> 15) * CRC16_POLY))
+#define CRC16_COEF(v, i)        (((v) >> (i)) & 1)
+#endif
+
+// Squares CRC16_SHIFT_<p> mod P into CRC16_SHIFT_<k>, through the products with x^1 .. x^15
+#define CRC16_SQUARE(k, p)                                                                                  \
+    CRC16_SQ##k##_1 = CRC16_MUL_X(CRC16_SHIFT_##p), CRC16_SQ##k##_2 = CRC16_MUL_X(CRC16_SQ##k##_1),           \
+    CRC16_SQ##k##_3 = CRC16_MUL_X(CRC16_SQ##k##_2), CRC16_SQ##k##_4 = CRC16_MUL_X(CRC16_SQ##k##_3),           \
+    CRC16_SQ##k##_5 = CRC16_MUL_X(CRC16_SQ##k##_4), CRC16_SQ##k##_6 = CRC16_MUL_X(CRC16_SQ##k##_5),           \
+    CRC16_SQ##k##_7 = CRC16_MUL_X(CRC16_SQ##k##_6), CRC16_SQ##k##_8 = CRC16_MUL_X(CRC16_SQ##k##_7),           \
+    CRC16_SQ##k##_9 = CRC16_MUL_X(CRC16_SQ##k##_8), CRC16_SQ##k##_10 = CRC16_MUL_X(CRC16_SQ##k##_9),          \
+    CRC16_SQ##k##_11 = CRC16_MUL_X(CRC16_SQ##k##_10), CRC16_SQ##k##_12 = CRC16_MUL_X(CRC16_SQ##k##_11),       \
+    CRC16_SQ##k##_13 = CRC16_MUL_X(CRC16_SQ##k##_12), CRC16_SQ##k##_14 = CRC16_MUL_X(CRC16_SQ##k##_13),       \
+    CRC16_SQ##k##_15 = CRC16_MUL_X(CRC16_SQ##k##_14),                                                        \
+    CRC16_SHIFT_##k = (CRC16_COEF(CRC16_SHIFT_##p, 0) * CRC16_SHIFT_##p) ^                                   \
+        (CRC16_COEF(CRC16_SHIFT_##p, 1) * CRC16_SQ##k##_1) ^ (CRC16_COEF(CRC16_SHIFT_##p, 2) * CRC16_SQ##k##_2) ^     \
+        (CRC16_COEF(CRC16_SHIFT_##p, 3) * CRC16_SQ##k##_3) ^ (CRC16_COEF(CRC16_SHIFT_##p, 4) * CRC16_SQ##k##_4) ^     \
+        (CRC16_COEF(CRC16_SHIFT_##p, 5) * CRC16_SQ##k##_5) ^ (CRC16_COEF(CRC16_SHIFT_##p, 6) * CRC16_SQ##k##_6) ^     \
+        (CRC16_COEF(CRC16_SHIFT_##p, 7) * CRC16_SQ##k##_7) ^ (CRC16_COEF(CRC16_SHIFT_##p, 8) * CRC16_SQ##k##_8) ^     \
+        (CRC16_COEF(CRC16_SHIFT_##p, 9) * CRC16_SQ##k##_9) ^ (CRC16_COEF(CRC16_SHIFT_##p, 10) * CRC16_SQ##k##_10) ^   \
+        (CRC16_COEF(CRC16_SHIFT_##p, 11) * CRC16_SQ##k##_11) ^ (CRC16_COEF(CRC16_SHIFT_##p, 12) * CRC16_SQ##k##_12) ^ \
+        (CRC16_COEF(CRC16_SHIFT_##p, 13) * CRC16_SQ##k##_13) ^ (CRC16_COEF(CRC16_SHIFT_##p, 14) * CRC16_SQ##k##_14) ^ \
+        (CRC16_COEF(CRC16_SHIFT_##p, 15) * CRC16_SQ##k##_15)
+
+// x^(8 * 2^k) mod P, evaluated by the compiler: x^8, then repeated squaring
+enum
+{
+    CRC16_X1 = CRC16_MUL_X(CRC16_ONE), CRC16_X2 = CRC16_MUL_X(CRC16_X1), CRC16_X3 = CRC16_MUL_X(CRC16_X2),
+    CRC16_X4 = CRC16_MUL_X(CRC16_X3), CRC16_X5 = CRC16_MUL_X(CRC16_X4), CRC16_X6 = CRC16_MUL_X(CRC16_X5),
+    CRC16_X7 = CRC16_MUL_X(CRC16_X6), CRC16_SHIFT_0 = CRC16_MUL_X(CRC16_X7),
+    CRC16_SQUARE(1, 0),   CRC16_SQUARE(2, 1),   CRC16_SQUARE(3, 2),   CRC16_SQUARE(4, 3),
+    CRC16_SQUARE(5, 4),   CRC16_SQUARE(6, 5),   CRC16_SQUARE(7, 6),   CRC16_SQUARE(8, 7),
+    CRC16_SQUARE(9, 8),   CRC16_SQUARE(10, 9),  CRC16_SQUARE(11, 10), CRC16_SQUARE(12, 11),
+    CRC16_SQUARE(13, 12), CRC16_SQUARE(14, 13), CRC16_SQUARE(15, 14), CRC16_SQUARE(16, 15),
+    CRC16_SQUARE(17, 16), CRC16_SQUARE(18, 17), CRC16_SQUARE(19, 18), CRC16_SQUARE(20, 19),
+    CRC16_SQUARE(21, 20), CRC16_SQUARE(22, 21), CRC16_SQUARE(23, 22), CRC16_SQUARE(24, 23),
+    CRC16_SQUARE(25, 24), CRC16_SQUARE(26, 25), CRC16_SQUARE(27, 26), CRC16_SQUARE(28, 27),
+    CRC16_SQUARE(29, 28), CRC16_SQUARE(30, 29), CRC16_SQUARE(31, 30)
+};
+
+// crc16_shift_table[k] holds x^(8 * 2^k) mod P
+static const uint16_t crc16_shift_table[CRC16_SHIFT_TABLE_SIZE] =
+{
+    CRC16_SHIFT_0,  CRC16_SHIFT_1,  CRC16_SHIFT_2,  CRC16_SHIFT_3,  CRC16_SHIFT_4,  CRC16_SHIFT_5,  CRC16_SHIFT_6,  CRC16_SHIFT_7,
+    CRC16_SHIFT_8,  CRC16_SHIFT_9,  CRC16_SHIFT_10, CRC16_SHIFT_11, CRC16_SHIFT_12, CRC16_SHIFT_13, CRC16_SHIFT_14, CRC16_SHIFT_15,
+    CRC16_SHIFT_16, CRC16_SHIFT_17, CRC16_SHIFT_18, CRC16_SHIFT_19, CRC16_SHIFT_20, CRC16_SHIFT_21, CRC16_SHIFT_22, CRC16_SHIFT_23,
+    CRC16_SHIFT_24, CRC16_SHIFT_25, CRC16_SHIFT_26, CRC16_SHIFT_27, CRC16_SHIFT_28, CRC16_SHIFT_29, CRC16_SHIFT_30, CRC16_SHIFT_31
+};
+
+// Multiplies one register contribution by x, i.e. feeds a single zero bit
+static uint16_t crc16_mul_x(uint16_t value)
+{
+    return (uint16_t)CRC16_MUL_X(value);
+}
+
+// Returns a * b mod P
+static uint16_t crc16_mul_mod(uint16_t a, uint16_t b)
+{
+    uint16_t product = 0;
+
+    // Add b * x^i for every coefficient of a that is set
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        if (CRC16_COEF(a, i))
+        {
+            product ^= b;
+        }
+        b = crc16_mul_x(b);
+    }
+
+    return product;
+}
+
+// Moves a register contribution past `bytes` trailing bytes, equivalent to feeding that many zeros
+static uint16_t crc16_shift(uint16_t value, uint32_t bytes)
+{
+    for (uint8_t k = 0; bytes != 0 && value != 0; k++, bytes >>= 1)
+    {
+        if (bytes & 1)
+        {
+            value = crc16_mul_mod(crc16_shift_table[k], value);
+        }
+    }
+
+    return value;
+}
+
+uint16_t crc16_update_range(uint16_t crc, uint32_t length, uint32_t offset,
+                            const uint8_t *old_bytes, const uint8_t *new_bytes, uint32_t count)
+{
+    uint16_t delta = 0;
+
+    // Zero-initialised CRC of old ^ new over the changed range only
+    for (uint32_t i = 0; i < count; i++)
+    {
+#if CRC16_REFLECTED
+        delta ^= (uint8_t)(old_bytes[i] ^ new_bytes[i]);
+#else
+        delta ^= (uint16_t)((old_bytes[i] ^ new_bytes[i]) << 8);
+#endif
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            delta = crc16_mul_x(delta);
+        }
+    }
+
+    return crc ^ crc16_shift(delta, length - offset - count);
+}
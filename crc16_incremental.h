@@ -0,0 +1,41 @@
+/**
+ * @file crc16_incremental.h
+ * @brief Incremental CRC16 Update
+ *
+ * Patches a stored CRC16 after a few bytes of a record changed, without recomputing
+ * `calculate_crc16()` over the whole record. It relies on CRC linearity: for two
+ * messages of equal length, crc(A) ^ crc(B) equals the zero-initialised CRC of A ^ B,
+ * independent of the initial value and final XOR used by `calculate_crc16()`. The
+ * contribution of a changed range is computed over the range only and then shifted
+ * past the trailing bytes using a const table of x^(8 * 2^k) mod P, which the compiler
+ * evaluates from `CRC16_POLYNOMIAL`. `journal_save()` seals every record this way.
+ *
+ * Cost is proportional to the number of changed bytes plus log2 of the record size.
+ *
+ * @note `CRC16_POLYNOMIAL` and `CRC16_REFLECTED` in `config.h` must describe the
+ *       algorithm implemented by `calculate_crc16()`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef CRC16_INCREMENTAL_H
+#define CRC16_INCREMENTAL_H
+
+#include "config.h"
+
+/**
+ * @brief Updates a CRC16 after a byte range of the covered data changed.
+ *
+ * @param crc CRC16 of the data before the change.
+ * @param length Number of bytes covered by the CRC.
+ * @param offset Offset of the changed range within the covered data.
+ * @param old_bytes Previous contents of the range.
+ * @param new_bytes New contents of the range.
+ * @param count Number of bytes in the range.
+ * @return CRC16 of the data after the change.
+ */
+uint16_t crc16_update_range(uint16_t crc, uint32_t length, uint32_t offset,
+                            const uint8_t *old_bytes, const uint8_t *new_bytes, uint32_t count);
+
+#endif // CRC16_INCREMENTAL_H
@@ -0,0 +1,282 @@
+#include "delta_journal.h"
+#include "record_format.h"
+#include "record_diff.h"
+#include "crc16_incremental.h"
+
+// Finds the next changed byte range at or after `from`. Ranges separated by fewer equal
+// bytes than an entry header are merged, since one larger entry is cheaper than two.
+static uint32_t journal_next_run(const uint8_t *buffer, const uint8_t *committed, uint32_t size, uint32_t from, uint32_t *length)
+{
+    uint32_t start = record_diff_find(buffer, committed, from, size);
+
+    if (start == size)
+    {
+        *length = 0;
+        return size;
+    }
+
+    uint32_t end = start + 1;                       // One past the last changed byte
+
+    for (uint32_t i = end; i < size && (i - start) < JOURNAL_MAX_DELTA; i++)
+    {
+        if (buffer[i] != committed[i])
+        {
+            end = i + 1;
+        }
+        else if ((i - end) >= JOURNAL_ENTRY_OVERHEAD)
+        {
+            break;
+        }
+    }
+
+    *length = end - start;
+    return start;
+}
+
+// Seals the CRC of `buffer` by patching the CRC of the committed copy with the changed payload
+// ranges, so the cost follows the bytes changed rather than the record size
+static void journal_seal(uint8_t *buffer, const uint8_t *committed, uint32_t size)
+{
+    uint32_t payload = size - 2;
+    uint16_t crc = le16_load(&committed[payload]);
+
+    for (uint32_t start = record_diff_find(buffer, committed, 0, payload); start < payload; )
+    {
+        uint32_t end = start + 1;
+
+        while (end < payload && buffer[end] != committed[end])
+        {
+            end++;
+        }
+
+        crc = crc16_update_range(crc, payload, start, &committed[start], &buffer[start], end - start);
+        start = record_diff_find(buffer, committed, end, payload);
+    }
+
+    le16_store(&buffer[payload], crc);
+}
+
+static eeprom_status_t journal_write_header(const struct_i2c_handle *i2c, uint16_t generation, uint8_t sector)
+{
+    uint8_t header[JOURNAL_HEADER_SIZE];
+
+    le16_store(&header[0], generation);
+    header[2] = sector;
+    record_crc_seal(header, sizeof(header));
+
+    return eeprom_bus_write(i2c, JOURNAL_ADDRESS, header, sizeof(header));
+}
+
+// Reads and validates the entry at `head`. Returns its length byte, or 0 if it is not a valid
+// entry of the current generation.
+static uint8_t journal_read_entry(const struct_i2c_handle *i2c, const struct_journal_t *journal, uint16_t head, uint8_t *entry, uint32_t size)
+{
+    if ((uint32_t)head + JOURNAL_ENTRY_OVERHEAD > JOURNAL_SIZE ||
+        eeprom_bus_read(i2c, JOURNAL_ADDRESS + head, entry, 5) != EEPROM_OK)
+    {
+        return 0;
+    }
+
+    uint8_t length = entry[2] & ~JOURNAL_ENTRY_MORE;
+
+    if (le16_load(&entry[0]) != journal->generation || length == 0 || length > JOURNAL_MAX_DELTA ||
+        (uint32_t)le16_load(&entry[3]) + length > size ||
+        (uint32_t)head + JOURNAL_ENTRY_OVERHEAD + length > JOURNAL_SIZE)
+    {
+        return 0;
+    }
+
+    if (eeprom_bus_read(i2c, JOURNAL_ADDRESS + head + 5, &entry[5], length + 2u) != EEPROM_OK ||
+        calculate_crc16(entry, 5u + length) != le16_load(&entry[5 + length]))
+    {
+        return 0;                                   // Torn append, everything after it is stale
+    }
+
+    return entry[2];
+}
+
+uint8_t journal_load(const struct_i2c_handle *i2c, struct_journal_t *journal, uint8_t *buffer, uint32_t size)
+{
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    uint8_t entry[JOURNAL_ENTRY_OVERHEAD + JOURNAL_MAX_DELTA];
+    uint16_t head = JOURNAL_HEADER_SIZE;
+    uint16_t entries = 0;
+
+    journal->sector = eeprom_sector_load(i2c, buffer, size);
+    journal->head = JOURNAL_HEADER_SIZE;
+    journal->entries = 0;
+    journal->valid = 0;
+    journal->sealed = 0;
+
+    if (journal->sector == SECTOR_ERROR)
+    {
+        return journal->sector;
+    }
+
+    if (eeprom_bus_read(i2c, JOURNAL_ADDRESS, header, sizeof(header)) != EEPROM_OK)
+    {
+        memset(header, EEPROM_BLANK_VALUE, sizeof(header));
+    }
+
+    journal->generation = le16_load(&header[0]);
+
+    // Blank or torn header, or a newer snapshot whose header was never written: the snapshot
+    // holds the record on its own and the next save writes a new one
+    if (!record_crc_valid(header, sizeof(header)) || header[2] != journal->sector)
+    {
+        return journal->sector;
+    }
+
+    journal->valid = 1;
+
+    // First pass finds the end of the last complete save, so a save interrupted between its
+    // entries is dropped as a whole instead of leaving the record half updated
+    while (entries < JOURNAL_MAX_ENTRIES)
+    {
+        uint8_t length = journal_read_entry(i2c, journal, head, entry, size);
+
+        if (length == 0)
+        {
+            break;
+        }
+
+        head += JOURNAL_ENTRY_OVERHEAD + (length & ~JOURNAL_ENTRY_MORE);
+        entries++;
+
+        if (!(length & JOURNAL_ENTRY_MORE))
+        {
+            journal->head = head;
+            journal->entries = entries;
+        }
+    }
+
+    // Second pass replays the complete saves
+    for (head = JOURNAL_HEADER_SIZE; head < journal->head; )
+    {
+        uint8_t length = journal_read_entry(i2c, journal, head, entry, size) & ~JOURNAL_ENTRY_MORE;
+
+        if (length == 0)
+        {
+            journal->head = head;                   // Became unreadable since the first pass
+            break;
+        }
+
+        memcpy(&buffer[le16_load(&entry[3])], &entry[5], length);
+        head += JOURNAL_ENTRY_OVERHEAD + length;
+    }
+
+    // Every complete save leaves a sealed record, so a bad CRC means the deltas do not belong
+    // to this snapshot. Keep the snapshot alone rather than a mix of both.
+    if (journal->head > JOURNAL_HEADER_SIZE && !record_crc_valid(buffer, size))
+    {
+        journal->sector = eeprom_sector_load(i2c, buffer, size);
+        journal->valid = 0;
+        journal->head = JOURNAL_HEADER_SIZE;
+        journal->entries = 0;
+    }
+
+    // Checked once here, every later save patches the CRC incrementally
+    journal->sealed = record_crc_valid(buffer, size);
+
+    return journal->sector;
+}
+
+uint8_t journal_compact(struct_i2c_handle *i2c, struct_journal_t *journal, uint8_t *buffer, uint32_t size)
+{
+    uint8_t sector = eeprom_sector_write(i2c, buffer, size, journal->sector);
+
+    if (sector == journal->sector)
+    {
+        return sector;                              // Snapshot not written, the journal stays as it is
+    }
+
+    journal->sector = sector;
+
+    // The header still names the previous snapshot, so if power is lost here the old deltas are
+    // not replayed over the new one. Until the header is written no delta may be appended.
+    journal->generation++;
+    journal->valid = journal_write_header(i2c, journal->generation, sector) == EEPROM_OK;
+    journal->head = JOURNAL_HEADER_SIZE;
+    journal->entries = 0;
+
+    return journal->sector;
+}
+
+uint8_t journal_save(struct_i2c_handle *i2c, struct_journal_t *journal, uint8_t *buffer, uint8_t *committed, uint32_t size)
+{
+    uint8_t entry[JOURNAL_ENTRY_OVERHEAD + JOURNAL_MAX_DELTA];
+    uint32_t entries = 0;
+    uint32_t bytes = 0;
+    uint32_t length = 0;
+
+    if (journal->sealed)
+    {
+        journal_seal(buffer, committed, size);
+    }
+    else
+    {
+        record_crc_seal(buffer, size);
+    }
+
+    // First pass sizes the deltas so a save that does not fit goes to a new snapshot instead
+    for (uint32_t offset = journal_next_run(buffer, committed, size, 0, &length);
+         length > 0;
+         offset = journal_next_run(buffer, committed, size, offset + length, &length))
+    {
+        entries++;
+        bytes += JOURNAL_ENTRY_OVERHEAD + length;
+    }
+
+    if (entries == 0)
+    {
+        return journal->sector;
+    }
+
+    if (!journal->valid || size > 0xFFFF ||
+        journal->entries + entries > JOURNAL_MAX_ENTRIES ||
+        journal->head + bytes > JOURNAL_SIZE)
+    {
+        uint8_t sector = journal->sector;
+
+        // The snapshot holds the record even if the journal header could not be written
+        if (journal_compact(i2c, journal, buffer, size) != sector)
+        {
+            memcpy(committed, buffer, size);
+            journal->sealed = 1;
+        }
+
+        return journal->sector;
+    }
+
+    uint16_t head = journal->head;
+    uint32_t remaining = entries;
+
+    for (uint32_t offset = journal_next_run(buffer, committed, size, 0, &length);
+         length > 0;
+         offset = journal_next_run(buffer, committed, size, offset + length, &length))
+    {
+        // Every entry but the last of a save is flagged, load only applies complete saves
+        remaining--;
+
+        le16_store(&entry[0], journal->generation);
+        entry[2] = (uint8_t)(length | (remaining > 0 ? JOURNAL_ENTRY_MORE : 0));
+        le16_store(&entry[3], (uint16_t)offset);
+        memcpy(&entry[5], &buffer[offset], length);
+        le16_store(&entry[5 + length], calculate_crc16(entry, 5 + length));
+
+        if (eeprom_bus_write(i2c, JOURNAL_ADDRESS + head, entry, JOURNAL_ENTRY_OVERHEAD + length) != EEPROM_OK)
+        {
+            // The partial save is ignored at load and overwritten by the next one
+            return journal->sector;
+        }
+
+        head += JOURNAL_ENTRY_OVERHEAD + length;
+    }
+
+    journal->head = head;
+    journal->entries += (uint16_t)entries;
+    memcpy(committed, buffer, size);
+    journal->sealed = 1;
+
+    return journal->sector;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file delta_journal.h
+ * @brief Snapshot + Delta Journal for Large Records
+ *
+ * Large records usually change a few fields per save. Instead of rewriting the whole
+ * record through `eeprom_sector_write()`, this module keeps the wear-levelled sectors
+ * as a periodic full snapshot and appends small (offset, bytes) delta entries to a
+ * journal region between snapshots. At load the deltas are replayed in RAM on top of
+ * the snapshot. When the journal runs out of space or reaches `JOURNAL_MAX_ENTRIES`,
+ * it is compacted by writing a new snapshot and starting a new journal generation.
+ *
+ * @note Configure `JOURNAL_ADDRESS`, `JOURNAL_SIZE`, `JOURNAL_MAX_ENTRIES` and
+ *       `JOURNAL_MAX_DELTA` in `config.h`. The snapshot is a sector record, so the large
+ *       record is `struct_data_t` itself and ends with its CRC like any other record.
+ *
+ * Usage:
+ * - Call `journal_load()` instead of `eeprom_sector_load()` at boot and keep a copy of
+ *   the loaded record as the committed state.
+ * - Call `journal_save()` with the new record and the committed copy on every save. The
+ *   record CRC is updated by `journal_save()`, there is no need to seal it beforehand.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef DELTA_JOURNAL_H
+#define DELTA_JOURNAL_H
+
+#include "wear_levelling.h"
+
+/**
+ * Journal Memory Map:
+ * +------------------------------+
+ * | Generation | Sector | CRC   |  -> 5 byte header, generation and sector of the current snapshot
+ * +------------------------------+
+ * | Gen | Len | Offset | Data | CRC |  -> Delta entry 0
+ * +------------------------------+
+ * | Gen | Len | Offset | Data | CRC |  -> Delta entry 1
+ * +------------------------------+
+ * |             ...              |
+ * +------------------------------+
+ *
+ * Entries are replayed in order until the first one with a foreign generation or a
+ * bad CRC. A save spanning several entries sets `JOURNAL_ENTRY_MORE` in the length byte
+ * of all but its last entry, and only complete saves are replayed.
+ *
+ * Deltas are only replayed over the snapshot sector named by the header. A compaction
+ * writes the new snapshot before the header, so after a power loss in between the new
+ * snapshot is loaded on its own: it already holds every delta, and replaying the old
+ * ones over it would roll bytes back. A replayed record that fails its CRC is dropped
+ * for the snapshot alone as a last line of defence.
+ */
+
+#define JOURNAL_HEADER_SIZE     5   ///< Generation (2) + sector (1) + CRC (2)
+#define JOURNAL_ENTRY_OVERHEAD  7   ///< Generation (2) + length (1) + offset (2) + CRC (2)
+#define JOURNAL_ENTRY_MORE      0x80    ///< Length flag: more entries of the same save follow
+
+// Journal state kept in RAM between load and save
+typedef struct {
+    uint8_t  sector;        ///< Active snapshot sector
+    uint8_t  valid;         ///< Journal header was found and names the loaded snapshot
+    uint8_t  sealed;        ///< The committed copy carries a valid CRC to patch
+    uint16_t generation;    ///< Generation of the current snapshot
+    uint16_t head;          ///< Offset of the next free byte in the journal region
+    uint16_t entries;       ///< Number of deltas appended since the last snapshot
+} struct_journal_t;
+
+/**
+ * @brief Loads the snapshot and replays the journal on top of it.
+ *
+ * Returns what `eeprom_sector_load()` returns, including `SECTOR_ERROR`.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param journal Journal state to initialize.
+ * @param buffer Pointer to the buffer where the record will be loaded.
+ * @param size Size of the record.
+ * @return The active snapshot sector index.
+ */
+uint8_t journal_load(const struct_i2c_handle *i2c, struct_journal_t *journal, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Saves a record as a set of deltas against the committed copy.
+ *
+ * The CRC of `buffer` is sealed by patching the CRC of the committed copy with the
+ * changed bytes only, see `crc16_incremental.h`. Changed byte ranges are appended to the
+ * journal. If they do not fit, the journal is compacted into a new snapshot instead.
+ * On success `committed` equals `buffer`.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param journal Journal state returned by `journal_load()`.
+ * @param buffer Pointer to the new record.
+ * @param committed Pointer to the last saved copy of the record.
+ * @param size Size of the record.
+ * @return The active snapshot sector index.
+ */
+uint8_t journal_save(struct_i2c_handle *i2c, struct_journal_t *journal, uint8_t *buffer, uint8_t *committed, uint32_t size);
+
+/**
+ * @brief Writes the record as a new snapshot and starts an empty journal.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param journal Journal state returned by `journal_load()`.
+ * @param buffer Pointer to the record.
+ * @param size Size of the record.
+ * @return The new active snapshot sector index.
+ */
+uint8_t journal_compact(struct_i2c_handle *i2c, struct_journal_t *journal, uint8_t *buffer, uint32_t size);
+
+#endif // DELTA_JOURNAL_H
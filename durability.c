@@ -0,0 +1,137 @@
+#include "durability.h"
+#include "record_format.h"
+
+_Static_assert(DURABILITY_VERIFY_ATTEMPTS > 0 && DURABILITY_VERIFY_ATTEMPTS < NUMBER_OF_SECTORS,
+               "A failed verified save must not overwrite the sector it falls back to");
+
+static struct_data_t durability_record;         // Pending cached record
+static uint32_t durability_size = 0;            // Size of the pending record, 0 if none
+static struct_durability_stats_t durability_stats;
+
+// Reads a sector back and compares it with what was written
+static uint8_t durability_verify(const struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size, uint8_t sector)
+{
+    struct_data_t image;
+    uint8_t status = SECTOR_INACTIVE;
+
+    if (eeprom_bus_read(i2c, sector_status_address[sector], &status, sizeof(status)) != EEPROM_OK ||
+        eeprom_bus_read(i2c, sector_address[sector], (uint8_t *)&image, size) != EEPROM_OK)
+    {
+        return 0;
+    }
+
+    return status == SECTOR_ACTIVE && record_crc_valid((uint8_t *)&image, size) && memcmp(&image, buffer, size) == 0;
+}
+
+// Makes `previous` the active sector again after `failed` did not verify
+static uint8_t durability_restore(struct_i2c_handle *i2c, uint8_t previous, uint8_t failed)
+{
+    uint8_t status = SECTOR_ACTIVE;
+
+    // Activate first, so an interruption leaves two active sectors rather than none
+    if (previous != SECTOR_NONE &&
+        eeprom_bus_write(i2c, sector_status_address[previous], &status, sizeof(status)) != EEPROM_OK)
+    {
+        return failed;
+    }
+
+    status = SECTOR_INACTIVE;
+    if (eeprom_bus_write(i2c, sector_status_address[failed], &status, sizeof(status)) != EEPROM_OK)
+    {
+        return failed;
+    }
+
+    return previous;
+}
+
+static uint8_t durability_write_verified(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector)
+{
+    uint8_t sector = current_sector;
+
+    for (uint8_t attempt = 0; attempt < DURABILITY_VERIFY_ATTEMPTS && attempt + 1 < sector_count; attempt++)
+    {
+        uint8_t next = eeprom_sector_write(i2c, buffer, size, sector);
+
+        // A failed transfer has already left the previous sector active
+        if (next == sector)
+        {
+            break;
+        }
+
+        durability_stats.written++;
+        sector = next;
+
+        if (durability_verify(i2c, buffer, size, sector))
+        {
+            durability_stats.verified++;
+            return sector;
+        }
+
+        durability_stats.mismatches++;
+    }
+
+    durability_stats.failures++;
+
+    return (sector == current_sector) ? current_sector : durability_restore(i2c, current_sector, sector);
+}
+
+uint8_t eeprom_sector_write_durable(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector, durability_t durability)
+{
+    uint8_t sector = current_sector;
+
+    // Cached and read-back records are held in `struct_data_t` buffers
+    if (size > sizeof(struct_data_t))
+    {
+        durability_stats.failures++;
+        return current_sector;
+    }
+
+    switch (durability)
+    {
+        case DURABILITY_CACHED:
+            memcpy(&durability_record, buffer, size);
+            durability_size = size;
+            durability_stats.cached++;
+            return current_sector;
+
+        case DURABILITY_WRITTEN:
+            sector = eeprom_sector_write(i2c, buffer, size, current_sector);
+            if (sector != current_sector)
+            {
+                durability_stats.written++;
+            }
+            break;
+
+        default:
+            sector = durability_write_verified(i2c, buffer, size, current_sector);
+            break;
+    }
+
+    // The saved record supersedes the cached one
+    if (sector != current_sector)
+    {
+        durability_size = 0;
+    }
+
+    return sector;
+}
+
+uint8_t durability_flush(struct_i2c_handle *i2c, uint8_t current_sector)
+{
+    if (durability_size == 0)
+    {
+        return current_sector;
+    }
+
+    return eeprom_sector_write_durable(i2c, (uint8_t *)&durability_record, durability_size, current_sector, DURABILITY_WRITTEN);
+}
+
+uint8_t durability_pending(void)
+{
+    return durability_size != 0;
+}
+
+const struct_durability_stats_t *durability_stats_get(void)
+{
+    return &durability_stats;
+}
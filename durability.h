@@ -0,0 +1,77 @@
+/**
+ * @file durability.h
+ * @brief Per-Save Durability Levels
+ *
+ * Not every save is worth the same. Losing a UI preference on power failure is harmless,
+ * losing a safety configuration is not. `eeprom_sector_write_durable()` takes the level
+ * a save needs:
+ * - `DURABILITY_CACHED`: the record is only kept in RAM until `durability_flush()` or a
+ *   later written save, so repeated saves cost no bus time at all.
+ * - `DURABILITY_WRITTEN`: the record is written as by `eeprom_sector_write()`.
+ * - `DURABILITY_VERIFIED`: the record is written, then read back and checked against its
+ *   CRC and the buffer. A mismatch moves it to the next sector, up to
+ *   `DURABILITY_VERIFY_ATTEMPTS` sectors. If none verifies, the previous sector is made
+ *   active again, so the save fails as a failed transfer does.
+ *
+ * A written or verified save also covers a pending cached record, as it holds the whole
+ * newer state.
+ *
+ * @note Configure `DURABILITY_VERIFY_ATTEMPTS` in `config.h`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef DURABILITY_H
+#define DURABILITY_H
+
+#include "wear_levelling.h"
+
+// Durability of a save
+typedef enum {
+    DURABILITY_CACHED = 0,          ///< RAM only until flushed, lost on reset
+    DURABILITY_WRITTEN,             ///< Written to the device
+    DURABILITY_VERIFIED             ///< Written, read back and checked
+} durability_t;
+
+// Save statistics since boot
+typedef struct {
+    uint32_t cached;                ///< Saves kept in RAM
+    uint32_t written;               ///< Records written, including flushes
+    uint32_t verified;              ///< Verified saves that succeeded
+    uint32_t mismatches;            ///< Read-backs that did not match
+    uint32_t failures;              ///< Verified saves that failed on every sector tried, and records too large
+} struct_durability_stats_t;
+
+/**
+ * @brief Saves a record with the given durability.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the record, with a valid CRC.
+ * @param size Size of the record, at most `sizeof(struct_data_t)`, or the save fails.
+ * @param current_sector Index of the currently active sector.
+ * @param durability Durability the save needs.
+ * @return The new active sector index, unchanged for a cached save or if the save failed.
+ */
+uint8_t eeprom_sector_write_durable(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector, durability_t durability);
+
+/**
+ * @brief Writes the pending cached record, if any.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param current_sector Index of the currently active sector.
+ * @return The new active sector index, unchanged if nothing was pending or the write failed.
+ */
+uint8_t durability_flush(struct_i2c_handle *i2c, uint8_t current_sector);
+
+/**
+ * @brief Returns 1 if a cached record has not been written yet.
+ */
+uint8_t durability_pending(void);
+
+/**
+ * @brief Returns the save statistics.
+ */
+const struct_durability_stats_t *durability_stats_get(void);
+
+#endif // DURABILITY_H
@@ -0,0 +1,150 @@
+#include "eeprom_bus.h"
+#include "latency_hist.h"
+#include <stddef.h>
+
+static struct_eeprom_stats_t eeprom_stats = {0};
+static eeprom_status_t eeprom_error = EEPROM_OK;
+
+#if EEPROM_BUS_RETRY
+
+// Performs a write of `out` or, if it is NULL, a read into `in`
+static eeprom_status_t eeprom_bus_transfer(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *out, uint8_t *in, uint32_t size)
+{
+    uint32_t start = eeprom_time_us();
+    uint8_t errors = 0;
+    eeprom_status_t status;
+
+    for (;;)
+    {
+        if (out != NULL)
+        {
+            status = eeprom_write_status(i2c, address, out, size);
+        }
+        else
+        {
+            status = eeprom_read_status(i2c, address, in, size);
+        }
+
+        if (status == EEPROM_OK)
+        {
+            return EEPROM_OK;
+        }
+
+        // A NACK is the normal reply during the write cycle of the previous write, so keep
+        // ACK polling until the time budget runs out; only other errors use up attempts.
+        // Those may have left a slave driving SDA, so free the bus first.
+        if (status != EEPROM_ERR_NACK)
+        {
+            LATENCY_BEGIN();
+            eeprom_bus_recover(i2c, EEPROM_RECOVERY_PULSES);
+            LATENCY_END(LATENCY_RECOVERY);
+            eeprom_stats.recoveries++;
+
+            if (++errors >= EEPROM_RETRY_ATTEMPTS)
+            {
+                break;
+            }
+        }
+
+        if ((uint32_t)(eeprom_time_us() - start) >= EEPROM_RETRY_TIMEOUT_US)
+        {
+            eeprom_stats.timeouts++;
+            status = EEPROM_ERR_TIMEOUT;
+            break;
+        }
+
+        eeprom_stats.retries++;
+    }
+
+    eeprom_stats.failures++;
+    eeprom_error = status;
+
+    return status;
+}
+
+#endif
+
+eeprom_status_t eeprom_bus_read(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size)
+{
+    eeprom_stats.reads++;
+
+#if EEPROM_BUS_RETRY
+    return eeprom_bus_transfer(i2c, address, NULL, data, size);
+#else
+    eeprom_read(i2c, address, data, size);
+    return EEPROM_OK;
+#endif
+}
+
+eeprom_status_t eeprom_bus_write(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size)
+{
+    eeprom_stats.writes++;
+
+#if EEPROM_BUS_RETRY
+    return eeprom_bus_transfer(i2c, address, data, NULL, size);
+#else
+    eeprom_write(i2c, address, data, size);
+    return EEPROM_OK;
+#endif
+}
+
+uint8_t eeprom_bus_batch(const struct_i2c_handle *i2c, const struct_eeprom_op_t *ops, uint8_t count)
+{
+    uint8_t done = 0;
+
+#if EEPROM_BATCH
+    done = eeprom_submit_batch(i2c, ops, count);
+
+    for (uint8_t i = 0; i < done; i++)
+    {
+        if (ops[i].type == EEPROM_OP_READ)
+        {
+            eeprom_stats.reads++;
+        }
+        else if (ops[i].type == EEPROM_OP_WRITE)
+        {
+            eeprom_stats.writes++;
+        }
+    }
+
+    // Finish one transfer at a time, so the failed one gets the usual retries
+#endif
+
+    for (; done < count; done++)
+    {
+        const struct_eeprom_op_t *op = &ops[done];
+        eeprom_status_t status = EEPROM_OK;
+
+        if (op->type == EEPROM_OP_READ)
+        {
+            status = eeprom_bus_read(i2c, op->address, op->data, op->size);
+        }
+        else if (op->type == EEPROM_OP_WRITE)
+        {
+            status = eeprom_bus_write(i2c, op->address, op->data, op->size);
+        }
+
+        if (status != EEPROM_OK)
+        {
+            break;
+        }
+    }
+
+    return done;
+}
+
+eeprom_status_t eeprom_last_error(void)
+{
+    return eeprom_error;
+}
+
+const struct_eeprom_stats_t *eeprom_stats_get(void)
+{
+    return &eeprom_stats;
+}
+
+void eeprom_stats_reset(void)
+{
+    eeprom_stats = (struct_eeprom_stats_t){0};
+    eeprom_error = EEPROM_OK;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file eeprom_bus.h
+ * @brief EEPROM Bus Access with Error Recovery and Statistics
+ *
+ * All library modules reach the EEPROM through `eeprom_bus_read()` and
+ * `eeprom_bus_write()`. With `EEPROM_BUS_RETRY` enabled these call the status-returning
+ * HAL hooks and retry failed transfers within a per-transfer time budget. A NACK, the
+ * normal reply while the device finishes the write cycle of the previous write, is
+ * ACK polled until the budget runs out. Arbitration loss and bus errors trigger a bus
+ * recovery (SCL pulses and a STOP) before the next attempt, and at most
+ * `EEPROM_RETRY_ATTEMPTS` of them are tolerated. The worst-case latency of a transfer is
+ * therefore bounded by `EEPROM_RETRY_TIMEOUT_US` plus one attempt, and a failure is
+ * reported to the caller instead of silently leaving a half-written slot.
+ *
+ * With `EEPROM_BUS_RETRY` disabled the void HAL hooks are used and every transfer is
+ * assumed to succeed, as before.
+ *
+ * Sequences known in advance, such as the transfers of a save, go through
+ * `eeprom_bus_batch()`, which drivers able to pipeline can take over with
+ * `eeprom_submit_batch()`.
+ *
+ * @note Configure `EEPROM_BUS_RETRY`, the retry policy and `EEPROM_BATCH` in `config.h`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef EEPROM_BUS_H
+#define EEPROM_BUS_H
+
+#include "config.h"
+
+// Bus statistics, counted since boot or the last reset
+typedef struct {
+    uint32_t reads;         ///< Read transfers requested
+    uint32_t writes;        ///< Write transfers requested
+    uint32_t retries;       ///< Extra attempts made after a failed attempt, ACK polls included
+    uint32_t recoveries;    ///< Bus recoveries issued
+    uint32_t failures;      ///< Transfers that failed after all attempts
+    uint32_t timeouts;      ///< Failures caused by the time budget running out
+} struct_eeprom_stats_t;
+
+/**
+ * @brief Reads from the EEPROM, retrying according to the configured policy.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param address EEPROM address to read from.
+ * @param data Destination buffer.
+ * @param size Number of bytes to read.
+ * @return `EEPROM_OK` or the error of the last attempt.
+ */
+eeprom_status_t eeprom_bus_read(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size);
+
+/**
+ * @brief Writes to the EEPROM, retrying according to the configured policy.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param address EEPROM address to write to.
+ * @param data Data to write.
+ * @param size Number of bytes to write.
+ * @return `EEPROM_OK` or the error of the last attempt.
+ */
+eeprom_status_t eeprom_bus_write(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Runs a sequence of operations the library knows it will issue.
+ *
+ * With `EEPROM_BATCH` enabled the sequence is handed to `eeprom_submit_batch()` in one
+ * call, so the driver can chain the transfers without per-transfer CPU work. Operations
+ * the driver did not complete, and all of them with `EEPROM_BATCH` disabled, are issued
+ * one by one through `eeprom_bus_read()` and `eeprom_bus_write()` with their retries.
+ * Polls are then implied, as the blocking hooks wait for the device themselves.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param ops Operations, run in order.
+ * @param count Number of operations.
+ * @return Number of operations completed, `count` on success. Later operations are not run.
+ */
+uint8_t eeprom_bus_batch(const struct_i2c_handle *i2c, const struct_eeprom_op_t *ops, uint8_t count);
+
+/**
+ * @brief Returns the result of the most recent failed transfer, or `EEPROM_OK` if none failed.
+ *
+ * Cleared by `eeprom_stats_reset()`.
+ */
+eeprom_status_t eeprom_last_error(void);
+
+/**
+ * @brief Returns the bus statistics.
+ */
+const struct_eeprom_stats_t *eeprom_stats_get(void);
+
+/**
+ * @brief Resets the bus statistics and the last error.
+ */
+void eeprom_stats_reset(void);
+
+#endif // EEPROM_BUS_H
@@ -0,0 +1,262 @@
+#include "hash_table.h"
+#include "record_format.h"
+
+#define HASH_NONE   0xFFFF          ///< No bucket
+
+// Outcome of a probe
+typedef enum {
+    HASH_FOUND = 0,                 ///< Key is in `bucket`
+    HASH_MISSING,                   ///< Key is absent, `bucket` is where it would go or HASH_NONE if full
+    HASH_ERROR                      ///< A bucket could not be read
+} hash_probe_t;
+
+static uint16_t hash_home(uint16_t key)
+{
+    return (uint16_t)((((uint32_t)key * 2654435761u) >> 16) % HASH_BUCKETS);
+}
+
+_Static_assert(HASH_ADDRESS % EEPROM_PAGE_SIZE == 0, "Slot planes must start on a page boundary");
+
+// Slot `slot` of every bucket lives in its own plane, so no page holds two slots of a bucket
+static uint16_t hash_slot_address(uint16_t bucket, uint8_t slot)
+{
+    return (uint16_t)(HASH_ADDRESS + slot * HASH_PLANE_SIZE + bucket * HASH_SLOT_SIZE);
+}
+
+// Reads the slots of a bucket, one per plane, into a bucket image
+static uint8_t hash_bucket_read(const struct_i2c_handle *i2c, uint16_t bucket, uint8_t *image)
+{
+    struct_eeprom_op_t ops[HASH_SLOTS];
+
+    for (uint8_t slot = 0; slot < HASH_SLOTS; slot++)
+    {
+        ops[slot] = (struct_eeprom_op_t){ EEPROM_OP_READ, hash_slot_address(bucket, slot), &image[slot * HASH_SLOT_SIZE], HASH_SLOT_SIZE };
+    }
+
+    return eeprom_bus_batch(i2c, ops, HASH_SLOTS) == HASH_SLOTS;
+}
+
+// Returns the valid slot with the highest sequence, or HASH_SLOTS if the bucket was never written
+static uint8_t hash_newest(const uint8_t *image)
+{
+    uint8_t newest = HASH_SLOTS;
+
+    for (uint8_t slot = 0; slot < HASH_SLOTS; slot++)
+    {
+        const uint8_t *entry = &image[slot * HASH_SLOT_SIZE];
+
+        if (!record_crc_valid(entry, HASH_SLOT_SIZE))
+        {
+            continue;
+        }
+
+        if (newest == HASH_SLOTS ||
+            (int16_t)(le16_load(&entry[2]) - le16_load(&image[newest * HASH_SLOT_SIZE + 2])) > 0)
+        {
+            newest = slot;
+        }
+    }
+
+    return newest;
+}
+
+// Walks the probe path of a key. On return `image` and `newest` describe `bucket`.
+static hash_probe_t hash_probe(const struct_i2c_handle *i2c, uint16_t key, uint8_t *image, uint16_t *bucket, uint8_t *newest)
+{
+    uint16_t home = hash_home(key);
+    uint16_t reuse = HASH_NONE;
+
+    for (uint16_t i = 0; i < HASH_BUCKETS; i++)
+    {
+        uint16_t index = (uint16_t)((home + i) % HASH_BUCKETS);
+
+        if (!hash_bucket_read(i2c, index, image))
+        {
+            return HASH_ERROR;
+        }
+
+        *bucket = index;
+        *newest = hash_newest(image);
+
+        // A never written or emptied bucket ends the probe path
+        if (*newest == HASH_SLOTS)
+        {
+            break;
+        }
+
+        uint16_t stored = le16_load(&image[*newest * HASH_SLOT_SIZE]);
+
+        if (stored == HASH_KEY_EMPTY)
+        {
+            break;
+        }
+
+        if (stored == key)
+        {
+            return HASH_FOUND;
+        }
+
+        if (stored == HASH_KEY_TOMBSTONE && reuse == HASH_NONE)
+        {
+            reuse = index;
+        }
+
+        if (i == HASH_BUCKETS - 1)
+        {
+            *bucket = HASH_NONE;
+        }
+    }
+
+    // Prefer the first tombstone on the path over the empty bucket that ended it
+    if (reuse != HASH_NONE)
+    {
+        if (!hash_bucket_read(i2c, reuse, image))
+        {
+            return HASH_ERROR;
+        }
+
+        *bucket = reuse;
+        *newest = hash_newest(image);
+    }
+
+    return HASH_MISSING;
+}
+
+// Sequence of the newest slot of a bucket image
+static uint16_t hash_sequence(const uint8_t *image, uint8_t newest)
+{
+    return (newest == HASH_SLOTS) ? UINT16_MAX : le16_load(&image[newest * HASH_SLOT_SIZE + 2]);
+}
+
+// Writes a new version of a bucket into the slot after its newest one
+static uint8_t hash_write(const struct_i2c_handle *i2c, uint16_t bucket, uint8_t newest, uint16_t sequence, uint16_t key, const uint8_t *value)
+{
+    uint8_t entry[HASH_SLOT_SIZE];
+    uint8_t slot = (newest == HASH_SLOTS) ? 0 : (uint8_t)((newest + 1) % HASH_SLOTS);
+
+    le16_store(&entry[0], key);
+    le16_store(&entry[2], (uint16_t)(sequence + 1));
+
+    if (value != NULL)
+    {
+        memcpy(&entry[4], value, HASH_VALUE_SIZE);
+    }
+    else
+    {
+        memset(&entry[4], 0, HASH_VALUE_SIZE);
+    }
+
+    record_crc_seal(entry, sizeof(entry));
+
+    return eeprom_bus_write(i2c, hash_slot_address(bucket, slot), entry, sizeof(entry)) == EEPROM_OK;
+}
+
+// Returns 1 if a bucket ends probe paths, reading it into `image`
+static uint8_t hash_empty(const struct_i2c_handle *i2c, uint16_t bucket, uint8_t *image, uint8_t *newest)
+{
+    if (!hash_bucket_read(i2c, bucket, image))
+    {
+        return 0;
+    }
+
+    *newest = hash_newest(image);
+
+    return *newest == HASH_SLOTS || le16_load(&image[*newest * HASH_SLOT_SIZE]) == HASH_KEY_EMPTY;
+}
+
+uint8_t hash_get(const struct_i2c_handle *i2c, uint16_t key, uint8_t *value)
+{
+    uint8_t image[HASH_BUCKET_SIZE];
+    uint16_t bucket = 0;
+    uint8_t newest = 0;
+
+    if (key >= HASH_KEY_TOMBSTONE || hash_probe(i2c, key, image, &bucket, &newest) != HASH_FOUND)
+    {
+        return 0;
+    }
+
+    memcpy(value, &image[newest * HASH_SLOT_SIZE + 4], HASH_VALUE_SIZE);
+
+    return 1;
+}
+
+uint8_t hash_put(const struct_i2c_handle *i2c, uint16_t key, const uint8_t *value)
+{
+    uint8_t image[HASH_BUCKET_SIZE];
+    uint16_t bucket = 0;
+    uint8_t newest = 0;
+
+    if (key >= HASH_KEY_TOMBSTONE)
+    {
+        return 0;
+    }
+
+    switch (hash_probe(i2c, key, image, &bucket, &newest))
+    {
+        case HASH_FOUND:
+            if (memcmp(&image[newest * HASH_SLOT_SIZE + 4], value, HASH_VALUE_SIZE) == 0)
+            {
+                return 1;
+            }
+            break;
+
+        case HASH_MISSING:
+            if (bucket == HASH_NONE)
+            {
+                return 0;                           // Table full
+            }
+            break;
+
+        default:
+            return 0;
+    }
+
+    return hash_write(i2c, bucket, newest, hash_sequence(image, newest), key, value);
+}
+
+uint8_t hash_delete(const struct_i2c_handle *i2c, uint16_t key)
+{
+    uint8_t image[HASH_BUCKET_SIZE];
+    uint16_t bucket = 0;
+    uint8_t newest = 0;
+    uint8_t next_newest = 0;
+
+    if (key >= HASH_KEY_TOMBSTONE || hash_probe(i2c, key, image, &bucket, &newest) != HASH_FOUND)
+    {
+        return 0;
+    }
+
+    uint16_t sequence = hash_sequence(image, newest);
+
+    // Later keys on the probe path must stay reachable, so leave a tombstone unless the path ends here
+    if (!hash_empty(i2c, (uint16_t)((bucket + 1) % HASH_BUCKETS), image, &next_newest))
+    {
+        return hash_write(i2c, bucket, newest, sequence, HASH_KEY_TOMBSTONE, NULL);
+    }
+
+    if (!hash_write(i2c, bucket, newest, sequence, HASH_KEY_EMPTY, NULL))
+    {
+        return 0;
+    }
+
+    // The path now ends here, so tombstones right before this bucket are no longer needed either.
+    // Without this, churn would eventually leave no empty bucket and every miss would scan the table.
+    for (uint16_t i = 1; i < HASH_BUCKETS; i++)
+    {
+        uint16_t previous = (uint16_t)((bucket + HASH_BUCKETS - i) % HASH_BUCKETS);
+
+        if (!hash_bucket_read(i2c, previous, image))
+        {
+            break;
+        }
+
+        newest = hash_newest(image);
+        if (newest == HASH_SLOTS || le16_load(&image[newest * HASH_SLOT_SIZE]) != HASH_KEY_TOMBSTONE ||
+            !hash_write(i2c, previous, newest, hash_sequence(image, newest), HASH_KEY_EMPTY, NULL))
+        {
+            break;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file hash_table.h
+ * @brief On-Device Open-Addressing Hash Table
+ *
+ * Stores small values under 16-bit keys in a fixed array of EEPROM buckets, so a lookup
+ * reads only the buckets on the key's probe path instead of a whole record, and no index
+ * is kept in RAM. A bucket holds one key and `HASH_SLOTS` version slots. An update writes
+ * the next slot of the bucket with a higher sequence number, which leaves the previous
+ * version intact if the write is interrupted. The slots of a bucket sit in separate pages,
+ * so the write cycles of a frequently updated key are spread over `HASH_SLOTS` pages; a
+ * lookup reads the slots of a bucket as one batch.
+ *
+ * Collisions are resolved by linear probing. A deleted key leaves a tombstone, which
+ * keeps later keys on the same probe path reachable and is reused by the next insert.
+ * Where the probe path ends right after the deleted key, the bucket and any tombstones
+ * before it are marked empty instead, so churn does not slowly fill the table with
+ * tombstones. With a load factor below about 0.7 most lookups read one bucket, a few
+ * read two.
+ *
+ * @note Configure `HASH_ADDRESS`, `HASH_BUCKETS`, `HASH_SLOTS` and `HASH_VALUE_SIZE`
+ *       in `config.h`. Keys `HASH_KEY_EMPTY` and `HASH_KEY_TOMBSTONE` are reserved.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include "wear_levelling.h"
+
+/**
+ * Table Layout, one page-aligned plane per slot:
+ * +--------------------------------------+
+ * | Slot 0 of bucket 0 | bucket 1 | ...  |  -> Plane 0
+ * +--------------------------------------+
+ * | Slot 1 of bucket 0 | bucket 1 | ...  |  -> Plane 1
+ * +--------------------------------------+
+ * |                 ...                  |  -> HASH_SLOTS planes
+ * +--------------------------------------+
+ *
+ * Each slot is Key | Sequence | Value | CRC16; the valid one with the highest sequence
+ * is current.
+ */
+
+#define HASH_SLOT_SIZE      (HASH_VALUE_SIZE + 6)       ///< Key (2) + sequence (2) + value + CRC (2)
+#define HASH_BUCKET_SIZE    (HASH_SLOTS * HASH_SLOT_SIZE)   ///< Bucket image in RAM, slot after slot
+#define HASH_PLANE_SIZE     ((HASH_BUCKETS * HASH_SLOT_SIZE + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE * EEPROM_PAGE_SIZE)  ///< One slot of every bucket, in whole pages
+#define HASH_TABLE_SIZE     (HASH_SLOTS * HASH_PLANE_SIZE)  ///< Device bytes used by the table
+#define HASH_KEY_EMPTY      0xFFFF                      ///< Reserved, an erased or emptied bucket
+#define HASH_KEY_TOMBSTONE  0xFFFE                      ///< Reserved, marks a deleted key
+
+/**
+ * @brief Looks up a key.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param key Key to find.
+ * @param value Buffer of `HASH_VALUE_SIZE` bytes.
+ * @return 1 if the key was found, 0 otherwise.
+ */
+uint8_t hash_get(const struct_i2c_handle *i2c, uint16_t key, uint8_t *value);
+
+/**
+ * @brief Inserts or updates a key. An unchanged value is not written again.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param key Key to store.
+ * @param value `HASH_VALUE_SIZE` bytes to store.
+ * @return 1 on success, 0 if the table is full or the write failed.
+ */
+uint8_t hash_put(const struct_i2c_handle *i2c, uint16_t key, const uint8_t *value);
+
+/**
+ * @brief Deletes a key.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param key Key to delete.
+ * @return 1 if the key was deleted, 0 if it was not found or the write failed.
+ */
+uint8_t hash_delete(const struct_i2c_handle *i2c, uint16_t key);
+
+#endif // HASH_TABLE_H
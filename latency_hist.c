@@ -0,0 +1,116 @@
+#include "latency_hist.h"
+
+#define LATENCY_SUB_BUCKETS     (1u << LATENCY_HIST_SUB_BITS)
+
+static struct_latency_hist_t latency_hist[LATENCY_OPERATIONS];
+
+// Maps a latency to its bucket: exact below 2^SUB_BITS, then SUB_BUCKETS linear steps per power of two
+static uint16_t latency_hist_bucket(uint32_t latency)
+{
+    uint8_t msb = LATENCY_HIST_SUB_BITS;
+
+    if (latency >= (1ul << LATENCY_HIST_RANGE_BITS))
+    {
+        latency = (1ul << LATENCY_HIST_RANGE_BITS) - 1;
+    }
+
+    if (latency < LATENCY_SUB_BUCKETS)
+    {
+        return (uint16_t)latency;
+    }
+
+    while ((latency >> (msb + 1)) != 0)
+    {
+        msb++;
+    }
+
+    return (uint16_t)(((msb - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS) +
+                      ((latency >> (msb - LATENCY_HIST_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1)));
+}
+
+void latency_hist_record(latency_op_t op, uint32_t latency)
+{
+    struct_latency_hist_t *hist = &latency_hist[op];
+    uint16_t bucket = latency_hist_bucket(latency);
+
+    if (hist->buckets[bucket] == UINT16_MAX)
+    {
+        for (uint16_t i = 0; i < LATENCY_HIST_BUCKETS; i++)
+        {
+            hist->buckets[i] >>= 1;
+        }
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+
+    if (latency > hist->max)
+    {
+        hist->max = latency;
+    }
+}
+
+const struct_latency_hist_t *latency_hist_get(latency_op_t op)
+{
+    return &latency_hist[op];
+}
+
+uint32_t latency_hist_bucket_limit(uint16_t index)
+{
+    if (index < LATENCY_SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    uint8_t shift = (uint8_t)((index >> LATENCY_HIST_SUB_BITS) - 1);
+    uint32_t lower = (LATENCY_SUB_BUCKETS + (index & (LATENCY_SUB_BUCKETS - 1))) << shift;
+
+    return lower + (1ul << shift) - 1;
+}
+
+uint32_t latency_hist_percentile(latency_op_t op, uint16_t per_mille)
+{
+    const struct_latency_hist_t *hist = &latency_hist[op];
+    uint32_t total = 0;
+    uint32_t seen = 0;
+
+    // Sum the buckets rather than use `count`, they may have been halved
+    for (uint16_t i = 0; i < LATENCY_HIST_BUCKETS; i++)
+    {
+        total += hist->buckets[i];
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    // Rank of the requested sample, rounded up so p100 is the last sample
+    uint32_t rank = (uint32_t)(((uint64_t)total * per_mille + 999) / 1000);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    for (uint16_t i = 0; i < LATENCY_HIST_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+
+        if (seen >= rank)
+        {
+            uint32_t limit = latency_hist_bucket_limit(i);
+
+            return (limit < hist->max) ? limit : hist->max;
+        }
+    }
+
+    return hist->max;
+}
+
+void latency_hist_reset(void)
+{
+    for (uint8_t op = 0; op < LATENCY_OPERATIONS; op++)
+    {
+        latency_hist[op] = (struct_latency_hist_t){0};
+    }
+}
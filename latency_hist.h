@@ -0,0 +1,92 @@
+/**
+ * @file latency_hist.h
+ * @brief Load, Save, Clear and Recovery Latency Histograms
+ *
+ * Averages hide the slow saves that matter. This module keeps one log-bucketed
+ * (HDR-style) histogram per operation in fixed RAM, so the tail latency of persistence
+ * can be read back from a board in the field. Each power of two is split into
+ * `2^LATENCY_HIST_SUB_BITS` linear buckets, which bounds the relative error of a reported
+ * percentile to `1 / 2^LATENCY_HIST_SUB_BITS` at any magnitude.
+ *
+ * Bucket counters are 16 bits. When one would overflow, every bucket of that histogram
+ * is halved, so old samples decay but the shape of the distribution is kept.
+ *
+ * @note Enable with `LATENCY_HIST` in `config.h` and implement `eeprom_time_us()`.
+ *       With `LATENCY_HIST` disabled the library is not instrumented at all.
+ *
+ * Usage:
+ * - Read `latency_hist_percentile(LATENCY_SAVE, 990)` for the p99 save latency.
+ * - Dump `latency_hist_get()` with `latency_hist_bucket_limit()` for the full distribution.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include "config.h"
+
+/// Number of buckets in each histogram
+#define LATENCY_HIST_BUCKETS    ((LATENCY_HIST_RANGE_BITS - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS)
+
+// Operations with a histogram
+typedef enum {
+    LATENCY_LOAD = 0,       ///< Sector load, including any reinitialization
+    LATENCY_SAVE,           ///< Sector write
+    LATENCY_CLEAR,          ///< Clear of a single sector
+    LATENCY_RECOVERY,       ///< Bus recovery issued by the retry policy
+    LATENCY_OPERATIONS      ///< Number of operations
+} latency_op_t;
+
+// Histogram of one operation
+typedef struct {
+    uint32_t count;                             ///< Samples recorded since the last reset
+    uint32_t max;                               ///< Largest sample in microseconds
+    uint16_t buckets[LATENCY_HIST_BUCKETS];     ///< Sample counts, halved together on overflow
+} struct_latency_hist_t;
+
+#if LATENCY_HIST
+#define LATENCY_BEGIN()     uint32_t latency_begin = eeprom_time_us()
+#define LATENCY_END(op)     latency_hist_record((op), eeprom_time_us() - latency_begin)
+#else
+#define LATENCY_BEGIN()
+#define LATENCY_END(op)
+#endif
+
+/**
+ * @brief Adds a sample to the histogram of an operation.
+ *
+ * @param op Operation the sample belongs to.
+ * @param latency Latency in microseconds.
+ */
+void latency_hist_record(latency_op_t op, uint32_t latency);
+
+/**
+ * @brief Returns the histogram of an operation.
+ */
+const struct_latency_hist_t *latency_hist_get(latency_op_t op);
+
+/**
+ * @brief Returns the largest latency that falls into a bucket.
+ *
+ * @param index Bucket index, below `LATENCY_HIST_BUCKETS`.
+ * @return Upper bound of the bucket in microseconds.
+ */
+uint32_t latency_hist_bucket_limit(uint16_t index);
+
+/**
+ * @brief Returns a percentile of the latency of an operation.
+ *
+ * @param op Operation to query.
+ * @param per_mille Percentile in tenths of a percent, e.g. 500 for the median, 999 for p99.9.
+ * @return Upper bound of the bucket holding the percentile in microseconds, 0 if empty.
+ */
+uint32_t latency_hist_percentile(latency_op_t op, uint16_t per_mille);
+
+/**
+ * @brief Clears all histograms.
+ */
+void latency_hist_reset(void);
+
+#endif // LATENCY_HIST_H
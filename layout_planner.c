@@ -0,0 +1,93 @@
+#include "layout_planner.h"
+
+_Static_assert(EEPROM_CAPACITY <= 0x10000, "Sector addresses are 16-bit");
+
+// Returns the end of a reserved region overlapping [start, end), or 0 if none does
+static uint32_t layout_overlap(uint32_t start, uint32_t end, const struct_layout_region_t *reserved, uint8_t reserved_count)
+{
+    for (uint8_t i = 0; i < reserved_count; i++)
+    {
+        uint32_t first = reserved[i].address;
+        uint32_t last = first + reserved[i].size;
+
+        if (reserved[i].size > 0 && start < last && first < end)
+        {
+            return last;
+        }
+    }
+
+    return 0;
+}
+
+// Places the sectors from the start of the device, at most `per_page` in one page, filling
+// the tables only if `fill` is set
+static uint8_t layout_place(uint32_t record_size, const struct_layout_region_t *reserved, uint8_t reserved_count,
+                            uint32_t per_page, uint8_t fill)
+{
+    uint32_t slot = record_size + 1;    // Record and status byte
+    uint32_t address = 0;
+    uint8_t count = 0;
+
+    while (count < NUMBER_OF_SECTORS)
+    {
+        uint32_t offset = address % EEPROM_PAGE_SIZE;
+
+        // Keep a sector within one page if it fits one, otherwise start it on a page
+        if (offset != 0 && (slot > EEPROM_PAGE_SIZE || offset + slot > EEPROM_PAGE_SIZE || offset / slot >= per_page))
+        {
+            address += EEPROM_PAGE_SIZE - offset;
+        }
+
+        if (address + slot > EEPROM_CAPACITY)
+        {
+            break;
+        }
+
+        uint32_t skip = layout_overlap(address, address + slot, reserved, reserved_count);
+        if (skip != 0)
+        {
+            address = skip;
+            continue;
+        }
+
+        if (fill)
+        {
+            sector_address[count] = (uint16_t)address;
+            sector_status_address[count] = (uint16_t)(address + record_size);
+        }
+
+        count++;
+        address += slot;
+    }
+
+    return count;
+}
+
+uint8_t layout_plan(uint32_t record_size, const struct_layout_region_t *reserved, uint8_t reserved_count)
+{
+    if (reserved == NULL)
+    {
+        reserved_count = 0;
+    }
+
+    // Every save writes a page cycle to the pages of the sectors it touches, so sectors sharing
+    // a page share its endurance. Share pages only as much as needed to reach NUMBER_OF_SECTORS.
+    uint32_t per_page = 1;
+    uint32_t most_per_page = EEPROM_PAGE_SIZE / (record_size + 1);
+
+    while (per_page < most_per_page &&
+           layout_place(record_size, reserved, reserved_count, per_page, 0) < NUMBER_OF_SECTORS)
+    {
+        per_page++;
+    }
+
+    if (layout_place(record_size, reserved, reserved_count, per_page, 0) < 3)
+    {
+        return 0;
+    }
+
+    eeprom_sector_map_init();
+    sector_count = layout_place(record_size, reserved, reserved_count, per_page, 1);
+
+    return sector_count;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file layout_planner.h
+ * @brief Runtime Sector Layout Planner
+ *
+ * The default sector map in `wear_levelling.c` spreads the sectors over `SECTOR_MAP_SIZE`,
+ * 4 KiB apart for four sectors, which leaves most of the device unused for a small record.
+ * Since every sector takes an equal share of the saves, more sectors directly extend the
+ * life of the device at no extra cost per save. `layout_plan()` fills `sector_status_address[]` and `sector_address[]`
+ * with as many sectors as fit the device outside the reserved regions, up to
+ * `NUMBER_OF_SECTORS`, and sets `sector_count`.
+ *
+ * Each sector is its record followed by its status byte. Sectors are placed so that the
+ * record spans as few pages as possible, i.e. no write cycle is added to a save:
+ * - A sector that fits a page never crosses a page boundary.
+ * - A larger sector starts on a page boundary.
+ *
+ * Each save costs a write cycle of every page it touches, so sectors sharing a page also
+ * share its endurance. Small sectors get a page each while that still places
+ * `NUMBER_OF_SECTORS`; only then do several share a page, as few as reach that count.
+ *
+ * @note Call `layout_plan()` at init, before any load or save, with the same arguments
+ *       on every boot. Records stored under a different layout are not found. Boot scans
+ *       read one status byte per sector, see `checkpoint.h` to bound them. Configure
+ *       `EEPROM_CAPACITY`, `EEPROM_PAGE_SIZE` and `NUMBER_OF_SECTORS` in `config.h`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef LAYOUT_PLANNER_H
+#define LAYOUT_PLANNER_H
+
+#include "wear_levelling.h"
+
+// Region of the device the sectors must not use, e.g. the journal or the queue
+typedef struct {
+    uint16_t address;               ///< First reserved byte
+    uint16_t size;                  ///< Number of reserved bytes
+} struct_layout_region_t;
+
+/**
+ * @brief Plans the sector layout and fills the sector address tables.
+ *
+ * @param record_size Size of the record, e.g. `sizeof(struct_data_t)`.
+ * @param reserved Regions to keep free, in any order, or NULL.
+ * @param reserved_count Number of reserved regions.
+ * @return Number of sectors placed, or 0 if fewer than three fit; the tables are then left unchanged.
+ */
+uint8_t layout_plan(uint32_t record_size, const struct_layout_region_t *reserved, uint8_t reserved_count);
+
+#endif // LAYOUT_PLANNER_H
@@ -0,0 +1,210 @@
+#include "multi_bus.h"
+#include "record_format.h"
+
+_Static_assert(MULTI_BUS_MAX <= SECTOR_DEVICES, "Every bus needs its own stale sector slot");
+
+// Step of the state machine of a bus
+typedef enum {
+    MULTI_STATUS = 0,                   ///< Reading the status byte of sector `index`
+    MULTI_RECORD,                       ///< Reading the record of candidate sector `index`
+    MULTI_DONE                          ///< Record loaded, or no valid sector left
+} multi_phase_t;
+
+// Marking of a sector, from its status byte and CRC
+typedef enum {
+    MULTI_INACTIVE = 0,                 ///< Not marked active, or the status could not be read
+    MULTI_ACTIVE,                       ///< Marked active, record not known to be corrupt
+    MULTI_CORRUPT                       ///< Marked active, record failed its CRC
+} multi_mark_t;
+
+// State of one bus
+typedef struct {
+    multi_phase_t phase;
+    uint8_t index;
+    uint8_t status;                     ///< Status byte being read
+    uint8_t started;                    ///< 1 if the current read was started asynchronously
+    uint8_t failed;                     ///< 1 if a read failed even after its retries
+    uint16_t address;                   ///< Current read, repeated through eeprom_bus_read() if it fails
+    uint8_t *data;
+    uint32_t size;
+    multi_mark_t mark[NUMBER_OF_SECTORS];
+} struct_multi_bus_t;
+
+static struct_multi_bus_t multi_bus[MULTI_BUS_MAX];
+
+static void multi_read(const struct_i2c_handle *i2c, struct_multi_bus_t *bus, uint16_t address, uint8_t *data, uint32_t size)
+{
+    bus->address = address;
+    bus->data = data;
+    bus->size = size;
+#if EEPROM_ASYNC_READ
+    bus->started = (eeprom_read_start(i2c, address, data, size) == EEPROM_OK);
+#else
+    (void)i2c;
+    bus->started = 0;
+#endif
+}
+
+// Returns the result of the current read, `EEPROM_BUSY` while it runs
+static eeprom_status_t multi_poll(const struct_i2c_handle *i2c, const struct_multi_bus_t *bus)
+{
+    eeprom_status_t status = EEPROM_ERR_BUS;
+
+#if EEPROM_ASYNC_READ
+    if (bus->started)
+    {
+        status = eeprom_read_done(i2c);
+
+        if (status == EEPROM_BUSY)
+        {
+            return status;
+        }
+    }
+#endif
+
+    if (status != EEPROM_OK)
+    {
+        status = eeprom_bus_read(i2c, bus->address, bus->data, bus->size);
+    }
+
+    return status;
+}
+
+// Newest candidate: the last of a run of active sectors, SECTOR_NONE if there is none
+static uint8_t multi_candidate(const multi_mark_t *mark)
+{
+    uint8_t candidate = SECTOR_NONE;
+
+    for (uint8_t i = 0; i < sector_count; i++)
+    {
+        if (mark[i] != MULTI_ACTIVE)
+        {
+            continue;
+        }
+
+        if (mark[(i + 1) % sector_count] != MULTI_ACTIVE)
+        {
+            return i;
+        }
+
+        candidate = i;
+    }
+
+    return candidate;
+}
+
+// Moves a bus on once its current read has completed
+static void multi_advance(struct_multi_bus_t *bus, struct_multi_load_t *load, eeprom_status_t status)
+{
+    if (status != EEPROM_OK)
+    {
+        bus->failed = 1;
+    }
+
+    if (bus->phase == MULTI_STATUS)
+    {
+        bus->mark[bus->index] = (status == EEPROM_OK && bus->status == SECTOR_ACTIVE) ? MULTI_ACTIVE : MULTI_INACTIVE;
+
+        if (++bus->index < sector_count)
+        {
+            multi_read(load->i2c, bus, sector_status_address[bus->index], &bus->status, sizeof(bus->status));
+            return;
+        }
+    }
+    else
+    {
+        if (status == EEPROM_OK && record_crc_valid(load->buffer, load->size))
+        {
+            load->sector = bus->index;
+            bus->phase = MULTI_DONE;
+            return;
+        }
+
+        bus->mark[bus->index] = MULTI_CORRUPT;
+    }
+
+    bus->index = multi_candidate(bus->mark);
+
+    if (bus->index == SECTOR_NONE)
+    {
+        bus->phase = MULTI_DONE;
+        return;
+    }
+
+    bus->phase = MULTI_RECORD;
+    multi_read(load->i2c, bus, sector_address[bus->index], load->buffer, load->size);
+}
+
+uint8_t eeprom_multi_load(struct_multi_load_t *loads, uint8_t count)
+{
+    uint8_t pending = 0;
+    uint8_t loaded = 0;
+
+    if (count > MULTI_BUS_MAX)
+    {
+        count = MULTI_BUS_MAX;
+    }
+
+    eeprom_sector_map_init();
+
+    for (uint8_t b = 0; b < count; b++)
+    {
+        struct_multi_bus_t *bus = &multi_bus[b];
+
+        loads[b].sector = SECTOR_NONE;
+        bus->phase = MULTI_STATUS;
+        bus->index = 0;
+        bus->failed = 0;
+        multi_read(loads[b].i2c, bus, sector_status_address[0], &bus->status, sizeof(bus->status));
+        pending++;
+    }
+
+    // Poll the buses in turn, each one starts its next read as soon as the previous ends
+    while (pending > 0)
+    {
+        for (uint8_t b = 0; b < count; b++)
+        {
+            struct_multi_bus_t *bus = &multi_bus[b];
+
+            if (bus->phase == MULTI_DONE)
+            {
+                continue;
+            }
+
+            eeprom_status_t status = multi_poll(loads[b].i2c, bus);
+
+            if (status == EEPROM_BUSY)
+            {
+                continue;
+            }
+
+            multi_advance(bus, &loads[b], status);
+
+            if (bus->phase == MULTI_DONE)
+            {
+                pending--;
+            }
+        }
+    }
+
+    for (uint8_t b = 0; b < count; b++)
+    {
+        uint8_t sector = loads[b].sector;
+
+        // Without a valid record a failed read means the device state is unknown
+        if (sector == SECTOR_NONE)
+        {
+            loads[b].sector = multi_bus[b].failed ? SECTOR_ERROR : SECTOR_NONE;
+            continue;
+        }
+
+        // A sector an interrupted save left active before the loaded one is released by the next
+        // save on this bus, as after eeprom_sector_load(). Nothing is written during the load.
+        uint8_t previous = (sector + sector_count - 1) % sector_count;
+        eeprom_sector_stale_set(loads[b].i2c, (multi_bus[b].mark[previous] != MULTI_INACTIVE) ? previous : SECTOR_NONE);
+
+        loaded++;
+    }
+
+    return loaded;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file multi_bus.h
+ * @brief Concurrent Load from EEPROMs on Separate I2C Controllers
+ *
+ * On boards with an EEPROM on each of several I2C controllers, loading them one after
+ * the other with `eeprom_sector_load()` makes boot take the sum of the bus times. Here
+ * every bus runs its own small state machine on the asynchronous read hooks: it reads
+ * the status bytes, then the record of the newest active sector, falling back to older
+ * active sectors whose CRC fails. The machines are polled in turn, so while one bus is
+ * transferring the others make progress and boot takes about as long as the slowest bus.
+ *
+ * A save leaves at most two neighbouring sectors active, the newer one last. For those
+ * states, given the three sectors or more `wear_levelling.c` requires, the sector chosen
+ * is the one `eeprom_sector_load()` would choose: the last active sector with a valid CRC
+ * in the run. Nothing is written during the load. An older sector left active by an
+ * interrupted save is recorded with `eeprom_sector_stale_set()` for its bus, so the next
+ * `eeprom_sector_write()` on that bus releases it, as after `eeprom_sector_load()`. A
+ * failed asynchronous read is repeated through `eeprom_bus_read()` with its retries.
+ *
+ * @note Configure `MULTI_BUS_MAX`, at most `SECTOR_DEVICES`, in `config.h`. With
+ *       `EEPROM_ASYNC_READ` set, implement `eeprom_read_start()` and `eeprom_read_done()`;
+ *       without it the buses are read in turn through `eeprom_bus_read()`, which gives
+ *       the same result without the overlap. Every bus uses the sector map of
+ *       `wear_levelling.c`, and the same handle must be used to save to it.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef MULTI_BUS_H
+#define MULTI_BUS_H
+
+#include "wear_levelling.h"
+
+// Record to load from one bus
+typedef struct {
+    const struct_i2c_handle *i2c;   ///< Bus of the EEPROM holding the record
+    uint8_t *buffer;                ///< Where the record is loaded
+    uint32_t size;                  ///< Size of the record
+    uint8_t sector;                 ///< Set to the active sector, `SECTOR_NONE` if none is valid, or `SECTOR_ERROR`
+} struct_multi_load_t;
+
+/**
+ * @brief Loads one record from each bus concurrently.
+ *
+ * Unlike `eeprom_sector_load()` nothing is initialized if no valid sector is found; the
+ * buffer of that record is then undefined. A record whose bus failed a read and has no
+ * valid sector gets `SECTOR_ERROR`, which `eeprom_sector_write()` refuses to save from.
+ *
+ * @param loads Records to load, one per bus.
+ * @param count Number of records, at most `MULTI_BUS_MAX`.
+ * @return Number of records loaded.
+ */
+uint8_t eeprom_multi_load(struct_multi_load_t *loads, uint8_t count);
+
+#endif // MULTI_BUS_H
@@ -0,0 +1,224 @@
+#include "persistent_queue.h"
+#include "record_format.h"
+
+_Static_assert(QUEUE_ACK_ADDRESS % EEPROM_PAGE_SIZE == 0, "Ack slots must start on a page boundary");
+
+static uint16_t queue_head = 0;             // Sequence of the oldest unacknowledged entry
+static uint16_t queue_next = 0;             // Sequence of the next entry
+static uint16_t queue_tail = 0;             // Slot of the next entry
+static uint8_t queue_ack_slot = QUEUE_ACK_SLOTS - 1;   // Ack slot written last
+
+static uint16_t queue_entry_address(uint16_t slot)
+{
+    return (uint16_t)(QUEUE_ADDRESS + slot * QUEUE_ENTRY_STRIDE);
+}
+
+// Reads an entry, returns 1 and its sequence if it passes its CRC
+static uint8_t queue_read_entry(const struct_i2c_handle *i2c, uint16_t slot, uint16_t *sequence, uint8_t *payload)
+{
+    uint8_t entry[QUEUE_ENTRY_STRIDE];
+
+    if (eeprom_bus_read(i2c, queue_entry_address(slot), entry, sizeof(entry)) != EEPROM_OK ||
+        !record_crc_valid(entry, sizeof(entry)))
+    {
+        return 0;
+    }
+
+    *sequence = le16_load(&entry[0]);
+
+    if (payload != NULL)
+    {
+        memcpy(payload, &entry[2], QUEUE_ENTRY_SIZE);
+    }
+
+    return 1;
+}
+
+// Reads the ack slots in one batch, returns 1 and the newest acknowledgement if there is one
+static uint8_t queue_read_ack(const struct_i2c_handle *i2c, uint16_t *head)
+{
+    uint8_t slots[QUEUE_ACK_SLOTS * QUEUE_ACK_SLOT_SIZE];
+    struct_eeprom_op_t ops[QUEUE_ACK_SLOTS];
+    uint8_t found = 0;
+
+    for (uint8_t i = 0; i < QUEUE_ACK_SLOTS; i++)
+    {
+        ops[i] = (struct_eeprom_op_t){ EEPROM_OP_READ, QUEUE_ACK_ADDRESS + i * EEPROM_PAGE_SIZE, &slots[i * QUEUE_ACK_SLOT_SIZE], QUEUE_ACK_SLOT_SIZE };
+    }
+
+    if (eeprom_bus_batch(i2c, ops, QUEUE_ACK_SLOTS) != QUEUE_ACK_SLOTS)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < QUEUE_ACK_SLOTS; i++)
+    {
+        const uint8_t *slot = &slots[i * QUEUE_ACK_SLOT_SIZE];
+        uint16_t sequence = le16_load(&slot[0]);
+
+        if (!record_crc_valid(slot, QUEUE_ACK_SLOT_SIZE))
+        {
+            continue;
+        }
+
+        if (!found || (int16_t)(sequence - *head) > 0)
+        {
+            *head = sequence;
+            queue_ack_slot = i;
+            found = 1;
+        }
+    }
+
+    return found;
+}
+
+uint16_t queue_load(const struct_i2c_handle *i2c)
+{
+    uint16_t first = 0;
+    uint16_t sequence = 0;
+    uint16_t newest = 0;
+    uint16_t oldest = 0;
+
+    if (queue_read_entry(i2c, 0, &first, NULL))
+    {
+        // Slots up to the newest entry hold first, first + 1, ... Past it the sequences jump back
+        // by QUEUE_ENTRIES, or the slots are blank or torn, so the match is monotonic.
+        uint16_t low = 0;
+        uint16_t high = QUEUE_ENTRIES - 1;
+
+        while (low < high)
+        {
+            uint16_t middle = (uint16_t)(low + (high - low + 1) / 2);
+
+            if (queue_read_entry(i2c, middle, &sequence, NULL) && sequence == (uint16_t)(first + middle))
+            {
+                low = middle;
+            }
+            else
+            {
+                high = (uint16_t)(middle - 1);
+            }
+        }
+
+        newest = low;
+        queue_next = (uint16_t)(first + newest + 1);
+        oldest = first;
+
+        // Past the newest entry the ring continues with the oldest surviving one. The slot right
+        // after it may hold a torn write, in which case the one after that is the oldest.
+        for (uint16_t slot = (uint16_t)(newest + 1); slot <= newest + 2 && slot < QUEUE_ENTRIES; slot++)
+        {
+            uint16_t expected = (uint16_t)(queue_next - QUEUE_ENTRIES + (slot - newest - 1));
+
+            if (queue_read_entry(i2c, slot, &sequence, NULL) && sequence == expected)
+            {
+                oldest = sequence;
+                break;
+            }
+        }
+    }
+    else if (queue_read_entry(i2c, QUEUE_ENTRIES - 1, &sequence, NULL))
+    {
+        // Slot 0 is torn, the ring had wrapped and slot QUEUE_ENTRIES - 1 is the newest entry
+        newest = QUEUE_ENTRIES - 1;
+        queue_next = (uint16_t)(sequence + 1);
+        oldest = (uint16_t)(queue_next - QUEUE_ENTRIES + 1);
+    }
+    else
+    {
+        // Empty ring, continue the sequence from any acknowledgement left behind
+        newest = QUEUE_ENTRIES - 1;
+        queue_next = queue_read_ack(i2c, &sequence) ? sequence : 0;
+        oldest = queue_next;
+    }
+
+    queue_tail = (uint16_t)((newest + 1) % QUEUE_ENTRIES);
+
+    if (!queue_read_ack(i2c, &queue_head) || (int16_t)(queue_head - oldest) < 0)
+    {
+        queue_head = oldest;
+    }
+
+    if ((int16_t)(queue_next - queue_head) < 0)
+    {
+        queue_head = queue_next;
+    }
+
+    return queue_count();
+}
+
+uint8_t queue_enqueue(const struct_i2c_handle *i2c, const uint8_t *payload)
+{
+    uint8_t entry[QUEUE_ENTRY_STRIDE];
+
+    if (queue_count() >= QUEUE_ENTRIES)
+    {
+        return 0;
+    }
+
+    le16_store(&entry[0], queue_next);
+    memcpy(&entry[2], payload, QUEUE_ENTRY_SIZE);
+    record_crc_seal(entry, sizeof(entry));
+
+    if (eeprom_bus_write(i2c, queue_entry_address(queue_tail), entry, sizeof(entry)) != EEPROM_OK)
+    {
+        return 0;
+    }
+
+    queue_next++;
+    queue_tail = (uint16_t)((queue_tail + 1) % QUEUE_ENTRIES);
+
+    return 1;
+}
+
+uint8_t queue_peek(const struct_i2c_handle *i2c, uint16_t index, uint8_t *payload)
+{
+    uint16_t sequence = 0;
+    uint16_t wanted = (uint16_t)(queue_head + index);
+
+    if (index >= queue_count())
+    {
+        return 0;
+    }
+
+    uint16_t slot = (uint16_t)((queue_tail + QUEUE_ENTRIES - (uint16_t)(queue_next - wanted)) % QUEUE_ENTRIES);
+
+    return queue_read_entry(i2c, slot, &sequence, payload) && sequence == wanted;
+}
+
+uint8_t queue_ack(const struct_i2c_handle *i2c, uint16_t count)
+{
+    uint8_t slot[QUEUE_ACK_SLOT_SIZE];
+    uint8_t next_slot = (uint8_t)((queue_ack_slot + 1) % QUEUE_ACK_SLOTS);
+
+    if (count > queue_count())
+    {
+        count = queue_count();
+    }
+
+    // Nothing to remove, spare the write cycle
+    if (count == 0)
+    {
+        return 1;
+    }
+
+    uint16_t head = (uint16_t)(queue_head + count);
+
+    le16_store(&slot[0], head);
+    record_crc_seal(slot, sizeof(slot));
+
+    if (eeprom_bus_write(i2c, QUEUE_ACK_ADDRESS + next_slot * EEPROM_PAGE_SIZE, slot, sizeof(slot)) != EEPROM_OK)
+    {
+        return 0;
+    }
+
+    queue_ack_slot = next_slot;
+    queue_head = head;
+
+    return 1;
+}
+
+uint16_t queue_count(void)
+{
+    return (uint16_t)(queue_next - queue_head);
+}
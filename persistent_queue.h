@@ -0,0 +1,99 @@
+/**
+ * @file persistent_queue.h
+ * @brief Persistent FIFO Queue for Store-and-Forward Records
+ *
+ * Buffers fixed-size entries in an EEPROM ring while they cannot be sent, and hands them
+ * out oldest first. Each entry carries a 16-bit sequence number and a CRC, and entries
+ * are written in ring order, so the newest entry is the last slot whose sequence still
+ * follows on from the first slot. `queue_load()` finds it with a binary search, reading
+ * about log2(`QUEUE_ENTRIES`) entries instead of the whole ring.
+ *
+ * Acknowledgements never touch the entries. The first unacknowledged sequence number is
+ * written to a rotating set of slots instead, one 4 byte write per `queue_ack()`, and
+ * read back in a single batch at boot. Each slot lives in a page of its own, so an ack
+ * page is written once every `QUEUE_ACK_SLOTS` acknowledgements, while an entry page is
+ * written once per enqueue spread over the `QUEUE_ENTRIES * QUEUE_ENTRY_STRIDE /
+ * EEPROM_PAGE_SIZE` pages of the ring. Acknowledge in batches of at least the ratio of
+ * the two page counts (8 entries with the defaults) so the ack pages wear no faster
+ * than the ring.
+ *
+ * A full queue rejects new entries, so nothing unacknowledged is ever overwritten.
+ *
+ * @note Configure `QUEUE_ADDRESS`, `QUEUE_ENTRIES`, `QUEUE_ENTRY_SIZE`,
+ *       `QUEUE_ACK_ADDRESS` and `QUEUE_ACK_SLOTS` in `config.h`.
+ *
+ * Usage:
+ * - Call `queue_load()` once at boot.
+ * - Call `queue_enqueue()` for every record to buffer.
+ * - Drain with `queue_peek()` from index 0 upwards, then `queue_ack()` what was sent.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef PERSISTENT_QUEUE_H
+#define PERSISTENT_QUEUE_H
+
+#include "wear_levelling.h"
+
+/**
+ * Queue Memory Map:
+ * +-----------------------------------+
+ * | Sequence | Payload | CRC16        |  -> Entry 0, at QUEUE_ADDRESS
+ * +-----------------------------------+
+ * |               ...                 |  -> QUEUE_ENTRIES entries written in ring order
+ * +-----------------------------------+
+ *
+ * +-----------------------------------+
+ * | First unacked sequence | CRC16    |  -> Ack slot 0, at QUEUE_ACK_ADDRESS
+ * +-----------------------------------+
+ * |               ...                 |  -> QUEUE_ACK_SLOTS slots written in turn,
+ * +-----------------------------------+     slot i at QUEUE_ACK_ADDRESS + i * EEPROM_PAGE_SIZE
+ */
+
+#define QUEUE_ENTRY_STRIDE      (QUEUE_ENTRY_SIZE + 4)  ///< Sequence (2) + payload + CRC (2)
+#define QUEUE_ACK_SLOT_SIZE     4                       ///< Sequence (2) + CRC (2)
+
+/**
+ * @brief Recovers the head and tail of the queue.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @return Number of unacknowledged entries.
+ */
+uint16_t queue_load(const struct_i2c_handle *i2c);
+
+/**
+ * @brief Appends an entry to the queue.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param payload `QUEUE_ENTRY_SIZE` bytes to store.
+ * @return 1 on success, 0 if the queue is full or the write failed.
+ */
+uint8_t queue_enqueue(const struct_i2c_handle *i2c, const uint8_t *payload);
+
+/**
+ * @brief Reads an unacknowledged entry without removing it.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param index Position from the oldest unacknowledged entry, 0 for the oldest.
+ * @param payload Buffer of `QUEUE_ENTRY_SIZE` bytes.
+ * @return 1 on success, 0 if there is no such entry or it failed its CRC.
+ */
+uint8_t queue_peek(const struct_i2c_handle *i2c, uint16_t index, uint8_t *payload);
+
+/**
+ * @brief Removes the oldest entries from the queue.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param count Number of entries to acknowledge, clamped to the queue length. Nothing is
+ *              written if this comes to 0.
+ * @return 1 on success, 0 if the acknowledgement could not be written.
+ */
+uint8_t queue_ack(const struct_i2c_handle *i2c, uint16_t count);
+
+/**
+ * @brief Returns the number of unacknowledged entries.
+ */
+uint16_t queue_count(void);
+
+#endif // PERSISTENT_QUEUE_H
@@ -0,0 +1,81 @@
+#include "record_diff.h"
+#include <string.h>
+
+#if defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 1)
+#include <arm_mve.h>
+#define RECORD_DIFF_BLOCK   16                      ///< Helium compares 16 bytes per step
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RECORD_DIFF_BLOCK   16                      ///< NEON compares 16 bytes per step
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RECORD_DIFF_BLOCK   16                      ///< SSE2 compares 16 bytes per step
+#else
+#define RECORD_DIFF_BLOCK   8                       ///< Two 32-bit words per step
+#endif
+
+// Returns non-zero if the RECORD_DIFF_BLOCK bytes at a and b differ. Loads are unaligned.
+static inline int record_diff_block(const uint8_t *a, const uint8_t *b)
+{
+#if defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 1)
+    return vcmpneq_u8(vld1q_u8(a), vld1q_u8(b)) != 0;
+#elif defined(__ARM_NEON)
+    uint64x2_t x = vreinterpretq_u64_u8(veorq_u8(vld1q_u8(a), vld1q_u8(b)));
+    return (vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1)) != 0;
+#elif defined(__SSE2__)
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)a), _mm_loadu_si128((const __m128i *)b));
+    return _mm_movemask_epi8(eq) != 0xFFFF;
+#else
+    uint32_t wa[2];
+    uint32_t wb[2];
+
+    memcpy(wa, a, sizeof(wa));                      // Compiles to plain loads, avoids alignment faults
+    memcpy(wb, b, sizeof(wb));
+    return ((wa[0] ^ wb[0]) | (wa[1] ^ wb[1])) != 0;
+#endif
+}
+
+uint32_t record_diff_find(const uint8_t *a, const uint8_t *b, uint32_t from, uint32_t size)
+{
+    while (from + RECORD_DIFF_BLOCK <= size && !record_diff_block(&a[from], &b[from]))
+    {
+        from += RECORD_DIFF_BLOCK;
+    }
+
+    while (from < size && a[from] == b[from])
+    {
+        from++;
+    }
+
+    return from;
+}
+
+uint32_t record_diff_pages(const uint8_t *a, const uint8_t *b, uint32_t size, uint16_t address, uint8_t *bitmap)
+{
+    uint32_t dirty = 0;
+    uint32_t page = 0;
+    uint32_t start = 0;
+
+    memset(bitmap, 0, RECORD_DIFF_BITMAP_SIZE(size));
+
+    while (start < size)
+    {
+        // End of the EEPROM page containing this part of the record
+        uint32_t end = start + EEPROM_PAGE_SIZE - ((address + start) % EEPROM_PAGE_SIZE);
+        if (end > size)
+        {
+            end = size;
+        }
+
+        if (record_diff_find(a, b, start, end) < end)
+        {
+            bitmap[page / 8] |= (uint8_t)(1u << (page % 8));
+            dirty++;
+        }
+
+        start = end;
+        page++;
+    }
+
+    return dirty;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file record_diff.h
+ * @brief Dirty Range Detection for Large Records
+ *
+ * Compares a record against its last committed copy to find what has to be written.
+ * The comparison runs 16 bytes at a time using SSE2, NEON or Helium (MVE) when the
+ * compiler targets them, and falls back to word-wide compares otherwise, so the
+ * diff stays negligible next to the bus time it saves.
+ *
+ * @note `EEPROM_PAGE_SIZE` in `config.h` sets the granularity of the dirty bitmap, which
+ *       sector saves use to skip unchanged pages when `SECTOR_DIFF_WRITE` is set.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef RECORD_DIFF_H
+#define RECORD_DIFF_H
+
+#include "config.h"
+
+/**
+ * @brief Number of bitmap bytes needed for a record of `size` bytes.
+ *
+ * One extra page is reserved because a record that does not start on a page
+ * boundary touches one more page than its size alone suggests.
+ */
+#define RECORD_DIFF_BITMAP_SIZE(size)   ((((size) + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE + 1 + 7) / 8)
+
+/**
+ * @brief Finds the first byte that differs between two buffers.
+ *
+ * @param a Pointer to the first buffer.
+ * @param b Pointer to the second buffer.
+ * @param from Offset to start searching at.
+ * @param size Size of both buffers.
+ * @return Offset of the first differing byte at or after `from`, or `size` if none.
+ */
+uint32_t record_diff_find(const uint8_t *a, const uint8_t *b, uint32_t from, uint32_t size);
+
+/**
+ * @brief Builds a bitmap of the EEPROM pages that hold changed bytes.
+ *
+ * Bit i of the bitmap is set when the i-th page touched by the record differs,
+ * counting from the page that contains `address`.
+ *
+ * @param a Pointer to the new record.
+ * @param b Pointer to the committed copy.
+ * @param size Size of the record.
+ * @param address EEPROM address the record is stored at.
+ * @param bitmap Output bitmap of at least `RECORD_DIFF_BITMAP_SIZE(size)` bytes.
+ * @return Number of dirty pages.
+ */
+uint32_t record_diff_pages(const uint8_t *a, const uint8_t *b, uint32_t size, uint16_t address, uint8_t *bitmap);
+
+#endif // RECORD_DIFF_H
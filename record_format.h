@@ -0,0 +1,150 @@
+/**
+ * @file record_format.h
+ * @brief Endianness-Stable On-Device Record Format
+ *
+ * Defines the byte layout of everything the library stores, independent of compiler
+ * padding and CPU byte order, so host tools and other MCUs can read EEPROM dumps
+ * directly. Multi-byte fields are little-endian and records carry no padding.
+ *
+ * The accessors below work on raw images (a record buffer or a memory-mapped dump).
+ * On little-endian targets they compile to plain, possibly unaligned, loads and stores;
+ * on big-endian targets they assemble the bytes explicitly.
+ *
+ * On-Device Format (all multi-byte fields little-endian):
+ * - Sector status:   Status (1) at `sector_status_address[]`
+ * - Sector record:   Payload (size - 2) | CRC16 (2) at `sector_address[]`
+ * - Journal header:  Generation (2) | Snapshot sector (1) | CRC16 (2)
+ * - Journal entry:   Generation (2) | More (bit 7) + Length (bits 0-6) (1) | Offset (2) | Data | CRC16 (2),
+ *                    More set on every entry of a save but its last
+ * - Pack page:       Record header (3..4) | { Id (1) | Length (1) | Data } | CRC16 (2)
+ * - Checkpoint slot: Sequence (2) | Sector (1) | CRC16 (2)
+ * - Schema record:   Version (1) | Fields of that version, packed | CRC16 (2)
+ * - Attribution:     Sequence (2) | { Saves (4) | Bytes (4) | Cycles (4) } per tag | CRC16 (2)
+ * - FRAM tier slot:  Sequence (4) | Sector record | CRC16 (2), in FRAM
+ * - Queue entry:     Sequence (2) | Payload | CRC16 (2)
+ * - Queue ack slot:  First unacknowledged sequence (2) | CRC16 (2)
+ * - Time series:     Page sequence (2) | First timestamp (4) | CRC16 (2) | { Timestamp (4) | Payload | CRC16 (2) }
+ * - Hash slot:       Key (2) | Sequence (2) | Value | CRC16 (2)
+ * - Sorted table:    Count (4) | Block entries (2) | Value size (2) | CRC16 (2), then blocks of
+ *                    { Key (4) | Value } * block entries | CRC16 (2), unused entries 0xFF
+ * - Scrub stamp:     Time of the last write (4) | CRC16 (2)
+ *
+ * The CRC16 of a sector record covers the payload and is stored in the last two bytes of
+ * the record, whatever `struct_data_t` looks like.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef RECORD_FORMAT_H
+#define RECORD_FORMAT_H
+
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define RECORD_FORMAT_NATIVE_LE 1   ///< Target byte order matches the on-device format
+#else
+#define RECORD_FORMAT_NATIVE_LE 0
+#endif
+
+// The record must end in its CRC with no padding anywhere, see WL_PACKED in config.h
+_Static_assert(sizeof(struct_data_t) == offsetof(struct_data_t, crc) + sizeof(uint16_t),
+               "struct_data_t must be packed and end with the CRC");
+
+static inline uint16_t le16_load(const uint8_t *p)
+{
+#if RECORD_FORMAT_NATIVE_LE
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+#else
+    return (uint16_t)(p[0] | (p[1] << 8));
+#endif
+}
+
+static inline void le16_store(uint8_t *p, uint16_t value)
+{
+#if RECORD_FORMAT_NATIVE_LE
+    memcpy(p, &value, sizeof(value));
+#else
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+#endif
+}
+
+static inline uint32_t le32_load(const uint8_t *p)
+{
+#if RECORD_FORMAT_NATIVE_LE
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+#else
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+#endif
+}
+
+static inline void le32_store(uint8_t *p, uint32_t value)
+{
+#if RECORD_FORMAT_NATIVE_LE
+    memcpy(p, &value, sizeof(value));
+#else
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+#endif
+}
+
+/**
+ * @brief Generates `<type>_get_<field>()` and `<type>_set_<field>()` for a field of a packed record.
+ *
+ * The accessors take a raw image of the record, so host tools can use them on dumps.
+ */
+#define RECORD_ACCESSORS_LE16(type, field)                                          \
+    static inline uint16_t type##_get_##field(const uint8_t *image)                 \
+    {                                                                               \
+        return le16_load(image + offsetof(type, field));                            \
+    }                                                                               \
+    static inline void type##_set_##field(uint8_t *image, uint16_t value)           \
+    {                                                                               \
+        le16_store(image + offsetof(type, field), value);                           \
+    }
+
+#define RECORD_ACCESSORS_LE32(type, field)                                          \
+    static inline uint32_t type##_get_##field(const uint8_t *image)                 \
+    {                                                                               \
+        return le32_load(image + offsetof(type, field));                            \
+    }                                                                               \
+    static inline void type##_set_##field(uint8_t *image, uint32_t value)           \
+    {                                                                               \
+        le32_store(image + offsetof(type, field), value);                           \
+    }
+
+RECORD_ACCESSORS_LE16(struct_data_t, crc)
+
+/**
+ * @brief Computes the CRC16 of a record and stores it little-endian in its last two bytes.
+ *
+ * @param record Pointer to the record image.
+ * @param size Size of the record including the CRC.
+ */
+static inline void record_crc_seal(uint8_t *record, uint32_t size)
+{
+    le16_store(&record[size - 2], calculate_crc16(record, size - 2));
+}
+
+/**
+ * @brief Checks the little-endian CRC16 stored in the last two bytes of a record.
+ *
+ * @param record Pointer to the record image.
+ * @param size Size of the record including the CRC.
+ * @return 1 if the CRC matches, 0 otherwise.
+ */
+static inline uint8_t record_crc_valid(const uint8_t *record, uint32_t size)
+{
+    return calculate_crc16(record, size - 2) == le16_load(&record[size - 2]);
+}
+
+#endif // RECORD_FORMAT_H
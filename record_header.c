@@ -0,0 +1,51 @@
+#include "record_header.h"
+
+uint8_t record_header_encode(const struct_record_header_t *header, uint8_t *out)
+{
+    uint32_t length = header->length;
+    uint8_t size = 2;
+
+    out[0] = header->type;
+    out[1] = header->sequence;
+
+    // Seven bits per byte, low bits first, top bit set while more bytes follow
+    while (length >= 0x80)
+    {
+        out[size++] = (uint8_t)(length | 0x80);
+        length >>= 7;
+    }
+    out[size++] = (uint8_t)length;
+
+    return size;
+}
+
+uint8_t record_header_decode(const uint8_t *in, uint32_t available, struct_record_header_t *header)
+{
+    uint32_t length = 0;
+
+    if (available < 3 || in[0] == RECORD_TYPE_BLANK)
+    {
+        return 0;
+    }
+
+    header->type = in[0];
+    header->sequence = in[1];
+
+    for (uint8_t i = 2; i < RECORD_HEADER_MAX_SIZE && i < available; i++)
+    {
+        length |= (uint32_t)(in[i] & 0x7F) << (7 * (i - 2));
+
+        if ((in[i] & 0x80) == 0)
+        {
+            header->length = length;
+            return i + 1;
+        }
+    }
+
+    return 0;                                       // Unterminated or longer than 32 bits
+}
+
+uint8_t record_sequence_newer(uint8_t a, uint8_t b)
+{
+    return (int8_t)(uint8_t)(a - b) > 0;
+}
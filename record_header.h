@@ -0,0 +1,71 @@
+/**
+ * @file record_header.h
+ * @brief Compact Variable-Length Record Headers
+ *
+ * Encodes the per-record header used by layouts that store more than the 1-byte sector
+ * status. A header is a type ID, a short 8-bit sequence number and the payload length as
+ * a varint (LEB128), so records shorter than 128 bytes carry only 3 bytes of header and
+ * records shorter than 16 KiB carry 4.
+ *
+ * Sequence numbers wrap around. `record_sequence_newer()` compares them using serial
+ * number arithmetic, which is correct as long as the records being compared are less
+ * than 128 sequence steps apart.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef RECORD_HEADER_H
+#define RECORD_HEADER_H
+
+#include "config.h"
+
+/**
+ * Record Header Layout:
+ * +------+----------+--------------------------+
+ * | Type | Sequence | Length (1 to 5 bytes)    |
+ * +------+----------+--------------------------+
+ */
+
+#define RECORD_HEADER_MAX_SIZE  7       ///< Type (1) + sequence (1) + 32-bit varint (5)
+#define RECORD_TYPE_BLANK       0xFF    ///< Erased EEPROM, never a valid type
+
+// Record type IDs used by the library
+#define RECORD_TYPE_PACK        0x01    ///< Page of packed small records (record_pack.c)
+
+// Decoded record header
+typedef struct {
+    uint8_t  type;          ///< Record type ID
+    uint8_t  sequence;      ///< Wrapping sequence number
+    uint32_t length;        ///< Payload length in bytes
+} struct_record_header_t;
+
+/**
+ * @brief Encodes a record header.
+ *
+ * @param header Header to encode.
+ * @param out Output buffer of at least `RECORD_HEADER_MAX_SIZE` bytes.
+ * @return Number of bytes written.
+ */
+uint8_t record_header_encode(const struct_record_header_t *header, uint8_t *out);
+
+/**
+ * @brief Decodes a record header.
+ *
+ * @param in Pointer to the encoded header.
+ * @param available Number of bytes readable at `in`.
+ * @param header Decoded header.
+ * @return Number of bytes consumed, or 0 if the header is blank, truncated or malformed.
+ */
+uint8_t record_header_decode(const uint8_t *in, uint32_t available, struct_record_header_t *header);
+
+/**
+ * @brief Checks whether sequence `a` is newer than sequence `b`, handling wrap-around.
+ *
+ * @param a First sequence number.
+ * @param b Second sequence number.
+ * @return 1 if `a` is newer than `b`, 0 otherwise.
+ */
+uint8_t record_sequence_newer(uint8_t a, uint8_t b);
+
+#endif // RECORD_HEADER_H
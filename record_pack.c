@@ -0,0 +1,184 @@
+#include "record_pack.h"
+#include "record_format.h"
+
+typedef struct {
+    uint8_t id;             ///< Record identifier stored in the page
+    uint8_t size;           ///< Record size in bytes
+    uint8_t dirty;          ///< Record changed since the last flush
+    uint8_t *data;          ///< Record contents in RAM
+} struct_pack_record_t;
+
+static struct_pack_record_t pack_records[PACK_MAX_RECORDS];
+static uint8_t pack_record_count = 0;
+static uint16_t pack_used = PACK_HEADER_SIZE + PACK_CRC_SIZE;  // Bytes a flush will write
+static uint8_t pack_sequence = 0;                               // Sequence of the newest page
+static uint8_t pack_page = PACK_PAGES - 1;                      // Ring index of the newest page
+
+static struct_pack_record_t *pack_find(uint8_t id)
+{
+    for (uint8_t i = 0; i < pack_record_count; i++)
+    {
+        if (pack_records[i].id == id)
+        {
+            return &pack_records[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Validates a page image and returns the length of its records, or 0 if it is blank or torn
+static uint16_t pack_page_length(const uint8_t *page, uint8_t *sequence)
+{
+    struct_record_header_t header;
+    uint8_t header_size = record_header_decode(page, EEPROM_PAGE_SIZE, &header);
+
+    if (header_size == 0 || header.type != RECORD_TYPE_PACK ||
+        header_size + header.length + PACK_CRC_SIZE > EEPROM_PAGE_SIZE)
+    {
+        return 0;
+    }
+
+    uint16_t end = (uint16_t)(header_size + header.length);
+    if (calculate_crc16(page, end) != le16_load(&page[end]))
+    {
+        return 0;
+    }
+
+    *sequence = header.sequence;
+    return (uint16_t)header.length;
+}
+
+uint8_t pack_register(uint8_t id, uint8_t *data, uint8_t size)
+{
+    if (pack_record_count >= PACK_MAX_RECORDS || pack_find(id) != NULL ||
+        pack_used + PACK_RECORD_OVERHEAD + size > EEPROM_PAGE_SIZE)
+    {
+        return 0;
+    }
+
+    pack_records[pack_record_count].id = id;
+    pack_records[pack_record_count].size = size;
+    pack_records[pack_record_count].dirty = 1;
+    pack_records[pack_record_count].data = data;
+    pack_record_count++;
+    pack_used += PACK_RECORD_OVERHEAD + size;
+
+    return 1;
+}
+
+uint8_t pack_load(const struct_i2c_handle *i2c)
+{
+    uint8_t page[EEPROM_PAGE_SIZE];
+    uint8_t newest = PACK_PAGES;
+    uint8_t restored = 0;
+    uint8_t sequence = 0;
+
+    for (uint8_t i = 0; i < PACK_PAGES; i++)
+    {
+        if (eeprom_bus_read(i2c, PACK_ADDRESS + i * EEPROM_PAGE_SIZE, page, EEPROM_PAGE_SIZE) == EEPROM_OK &&
+            pack_page_length(page, &sequence) != 0 &&
+            (newest == PACK_PAGES || record_sequence_newer(sequence, pack_sequence)))
+        {
+            newest = i;
+            pack_sequence = sequence;
+        }
+    }
+
+    if (newest == PACK_PAGES)
+    {
+        return 0;                                   // Blank ring, keep the defaults in RAM
+    }
+
+    pack_page = newest;
+    if (eeprom_bus_read(i2c, PACK_ADDRESS + newest * EEPROM_PAGE_SIZE, page, EEPROM_PAGE_SIZE) != EEPROM_OK ||
+        pack_page_length(page, &sequence) == 0)
+    {
+        return 0;
+    }
+
+    struct_record_header_t header;
+    uint16_t offset = record_header_decode(page, EEPROM_PAGE_SIZE, &header);
+    uint16_t end = (uint16_t)(offset + header.length);
+
+    while (offset + PACK_RECORD_OVERHEAD <= end)
+    {
+        struct_pack_record_t *record = pack_find(page[offset]);
+        uint8_t size = page[offset + 1];
+
+        if (offset + PACK_RECORD_OVERHEAD + size > end)
+        {
+            break;
+        }
+
+        if (record != NULL && record->size == size)
+        {
+            memcpy(record->data, &page[offset + PACK_RECORD_OVERHEAD], size);
+            record->dirty = 0;
+            restored++;
+        }
+
+        offset += PACK_RECORD_OVERHEAD + size;
+    }
+
+    return restored;
+}
+
+void pack_mark_dirty(uint8_t id)
+{
+    struct_pack_record_t *record = pack_find(id);
+
+    if (record != NULL)
+    {
+        record->dirty = 1;
+    }
+}
+
+uint8_t pack_flush(const struct_i2c_handle *i2c)
+{
+    uint8_t page[EEPROM_PAGE_SIZE];
+    uint8_t dirty = 0;
+    struct_record_header_t header;
+
+    for (uint8_t i = 0; i < pack_record_count; i++)
+    {
+        dirty |= pack_records[i].dirty;
+    }
+
+    if (!dirty)
+    {
+        return 0;
+    }
+
+    pack_sequence++;
+    pack_page = (pack_page + 1) % PACK_PAGES;
+
+    header.type = RECORD_TYPE_PACK;
+    header.sequence = pack_sequence;
+    header.length = pack_used - PACK_HEADER_SIZE - PACK_CRC_SIZE;
+
+    uint16_t offset = record_header_encode(&header, page);
+
+    for (uint8_t i = 0; i < pack_record_count; i++)
+    {
+        page[offset] = pack_records[i].id;
+        page[offset + 1] = pack_records[i].size;
+        memcpy(&page[offset + PACK_RECORD_OVERHEAD], pack_records[i].data, pack_records[i].size);
+        offset += PACK_RECORD_OVERHEAD + pack_records[i].size;
+    }
+
+    le16_store(&page[offset], calculate_crc16(page, offset));
+
+    // Page aligned, so the whole update costs a single write cycle
+    if (eeprom_bus_write(i2c, PACK_ADDRESS + pack_page * EEPROM_PAGE_SIZE, page, offset + PACK_CRC_SIZE) != EEPROM_OK)
+    {
+        return 0;                                   // Records stay dirty, the next flush retries on the following page
+    }
+
+    for (uint8_t i = 0; i < pack_record_count; i++)
+    {
+        pack_records[i].dirty = 0;
+    }
+
+    return 1;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file record_pack.h
+ * @brief Small Record Packing into Shared Page Writes
+ *
+ * Small records such as counters and settings cost a full write cycle each when saved
+ * on their own. This module keeps a table of registered small records and writes all
+ * of them together as one page, so a single write cycle carries every pending update.
+ * Pages rotate through a ring for wear levelling and the newest valid page is decoded
+ * at load.
+ *
+ * Since a page write costs the same regardless of how many bytes it carries, every
+ * page holds all registered records. Each page is therefore self-contained and older
+ * pages can be overwritten freely.
+ *
+ * @note Configure `PACK_ADDRESS`, `PACK_PAGES` and `PACK_MAX_RECORDS` in `config.h`.
+ *
+ * Usage:
+ * - Register each small record with `pack_register()` once at startup.
+ * - Call `pack_load()` to restore the registered records.
+ * - Call `pack_mark_dirty()` after changing a record and `pack_flush()` to save.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef RECORD_PACK_H
+#define RECORD_PACK_H
+
+#include "wear_levelling.h"
+#include "record_header.h"
+
+/**
+ * Pack Page Layout (one EEPROM page):
+ * +---------------+-----------------------------+-----+-------+
+ * | Record header | Id | Len | Data | Id | ... | CRC | Blank |
+ * +---------------+-----------------------------+-----+-------+
+ *
+ * The page starts with a compact record header (see record_header.h) of type
+ * `RECORD_TYPE_PACK` whose length covers the packed records. The 8-bit sequence
+ * requires `PACK_PAGES` to stay below 128.
+ */
+
+#define PACK_HEADER_SIZE        ((EEPROM_PAGE_SIZE) <= 128 ? 3 : 4)    ///< Compact header for a page-sized payload
+#define PACK_RECORD_OVERHEAD    2   ///< Id (1) + length (1)
+#define PACK_CRC_SIZE           2   ///< CRC16 after the last record
+
+/**
+ * @brief Registers a small record to be stored in the pack ring.
+ *
+ * @param id Unique identifier of the record.
+ * @param data Pointer to the record in RAM.
+ * @param size Size of the record in bytes.
+ * @return 1 on success, 0 if the table is full or the records no longer fit in a page.
+ */
+uint8_t pack_register(uint8_t id, uint8_t *data, uint8_t size);
+
+/**
+ * @brief Restores all registered records from the newest valid page.
+ *
+ * Records missing from the page keep their current RAM contents.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @return Number of records restored.
+ */
+uint8_t pack_load(const struct_i2c_handle *i2c);
+
+/**
+ * @brief Marks a registered record as changed.
+ *
+ * @param id Identifier of the record.
+ */
+void pack_mark_dirty(uint8_t id);
+
+/**
+ * @brief Writes all registered records as one page if any of them changed.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @return 1 if a page was written, 0 otherwise.
+ */
+uint8_t pack_flush(const struct_i2c_handle *i2c);
+
+#endif // RECORD_PACK_H
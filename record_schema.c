@@ -0,0 +1,108 @@
+#include "record_schema.h"
+#include "record_format.h"
+
+#define SCHEMA_DESC_FIELD(type, name, dimensions, since)    { offsetof(struct_record_t, name), sizeof(type dimensions), (since), 0 },
+#define SCHEMA_DESC_RETIRED(name, size, since, until)       { 0, (size), (since), (until) },
+
+_Static_assert(SECTOR_MAP_SIZE / NUMBER_OF_SECTORS >= RECORD_SCHEMA_MAX_SIZE + 2,
+               "The default sector map must hold the status byte and a record of any version");
+
+const struct_schema_field_t record_schema_fields[] =
+{
+    RECORD_SCHEMA(SCHEMA_DESC_FIELD, SCHEMA_DESC_RETIRED)
+};
+
+const uint8_t record_schema_field_count = sizeof(record_schema_fields) / sizeof(record_schema_fields[0]);
+
+static uint8_t schema_field_present(const struct_schema_field_t *field, uint8_t version)
+{
+    return version >= field->since && (field->until == 0 || version < field->until);
+}
+
+uint32_t schema_record_size(uint8_t version)
+{
+    uint32_t size = 3;                              // Version byte and CRC
+
+    if (version == 0 || version > RECORD_SCHEMA_VERSION)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < record_schema_field_count; i++)
+    {
+        if (schema_field_present(&record_schema_fields[i], version))
+        {
+            size += record_schema_fields[i].size;
+        }
+    }
+
+    return size;
+}
+
+uint8_t schema_upgrade(const uint8_t *image, struct_record_t *record, const struct_record_t *defaults)
+{
+    uint8_t version = image[0];
+    uint32_t offset = 1;
+
+    if (schema_record_size(version) == 0)
+    {
+        return 0;
+    }
+
+    memcpy(record, defaults, sizeof(struct_record_t));
+
+    // Walk the stored layout, keeping fields that still exist and skipping retired ones
+    for (uint8_t i = 0; i < record_schema_field_count; i++)
+    {
+        const struct_schema_field_t *field = &record_schema_fields[i];
+
+        if (!schema_field_present(field, version))
+        {
+            continue;
+        }
+
+        if (field->until == 0)
+        {
+            memcpy((uint8_t *)record + field->offset, &image[offset], field->size);
+        }
+
+        offset += field->size;
+    }
+
+    record->version = RECORD_SCHEMA_VERSION;
+    record_crc_seal((uint8_t *)record, sizeof(struct_record_t));
+
+    return 1;
+}
+
+// The version byte tells the length of the stored record
+static uint32_t schema_image_size(const uint8_t *image)
+{
+    return schema_record_size(image[0]);
+}
+
+uint8_t schema_sector_load(const struct_i2c_handle *i2c, struct_record_t *record, const struct_record_t *defaults)
+{
+    uint8_t image[RECORD_SCHEMA_MAX_SIZE];
+    uint8_t scratch[RECORD_SCHEMA_MAX_SIZE];
+
+    // Read enough for any version, the scan checks the CRC over the size of the stored one
+    uint8_t sector = eeprom_sector_find(i2c, image, scratch, sizeof(image), schema_image_size);
+
+    if (sector < sector_count && schema_upgrade(image, record, defaults))
+    {
+        return sector;
+    }
+
+    memcpy(record, defaults, sizeof(struct_record_t));
+
+    return sector;
+}
+
+uint8_t schema_sector_write(struct_i2c_handle *i2c, struct_record_t *record, uint8_t current_sector)
+{
+    record->version = RECORD_SCHEMA_VERSION;
+    record_crc_seal((uint8_t *)record, sizeof(struct_record_t));
+
+    return eeprom_sector_write(i2c, (uint8_t *)record, sizeof(struct_record_t), current_sector);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file record_schema.h
+ * @brief Versioned Record Schema with Lazy Upgrade
+ *
+ * Generates the packed record structure, its field offset table and the upgrade path
+ * for older versions from the `RECORD_SCHEMA` list in `config.h`. The C preprocessor
+ * does the generation, so there is no separate build step.
+ *
+ * Every stored record starts with its schema version. When a record written by older
+ * firmware is loaded, it is upgraded in RAM: fields it already had are copied from their
+ * old offsets, new fields take their value from the caller's defaults and retired fields
+ * are dropped. Nothing is written at load; the record reaches the device in the current
+ * version at the next natural save, so a firmware update costs no migration write.
+ *
+ * @note Describe the record with `RECORD_SCHEMA` and `RECORD_SCHEMA_VERSION` in `config.h`.
+ *
+ * Usage:
+ * - Call `schema_sector_load()` at boot instead of `eeprom_sector_load()`.
+ * - Call `schema_sector_write()` to save instead of `eeprom_sector_write()`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef RECORD_SCHEMA_H
+#define RECORD_SCHEMA_H
+
+#include "wear_levelling.h"
+
+#define SCHEMA_STRUCT_FIELD(type, name, dimensions, since)      type name dimensions;
+#define SCHEMA_STRUCT_RETIRED(name, size, since, until)
+#define SCHEMA_SIZE_FIELD(type, name, dimensions, since)        + sizeof(type dimensions)
+#define SCHEMA_SIZE_RETIRED(name, size, since, until)           + (size)
+
+// Current version of the record, generated from RECORD_SCHEMA
+typedef struct WL_PACKED {
+    uint8_t version;                                            ///< Schema version the record was written with
+    RECORD_SCHEMA(SCHEMA_STRUCT_FIELD, SCHEMA_STRUCT_RETIRED)
+    uint16_t crc;                                               ///< CRC16, little-endian
+} struct_record_t;
+
+/// Upper bound on the size of a record of any version
+#define RECORD_SCHEMA_MAX_SIZE  (3 RECORD_SCHEMA(SCHEMA_SIZE_FIELD, SCHEMA_SIZE_RETIRED))
+
+// Field descriptor generated for each FIELD and RETIRED entry
+typedef struct {
+    uint16_t offset;        ///< Offset in `struct_record_t`, unused for retired fields
+    uint16_t size;          ///< Size of the field in bytes
+    uint8_t since;          ///< First version containing the field
+    uint8_t until;          ///< First version without the field, 0 if still present
+} struct_schema_field_t;
+
+extern const struct_schema_field_t record_schema_fields[];  ///< Field offset table in list order
+extern const uint8_t record_schema_field_count;             ///< Number of entries in `record_schema_fields`
+
+/**
+ * @brief Returns the stored size of a record written with an older or current version.
+ *
+ * @param version Schema version.
+ * @return Size in bytes including version byte and CRC, or 0 if the version is unknown.
+ */
+uint32_t schema_record_size(uint8_t version);
+
+/**
+ * @brief Upgrades a record image of any known version to the current version.
+ *
+ * @param image Stored record image, starting with its version byte.
+ * @param record Current version record, updated in place.
+ * @param defaults Values for fields the stored version does not have.
+ * @return 1 on success, 0 if the version is unknown.
+ */
+uint8_t schema_upgrade(const uint8_t *image, struct_record_t *record, const struct_record_t *defaults);
+
+/**
+ * @brief Loads the most recent valid record of any known version.
+ *
+ * Uses the scan of `eeprom_sector_load()` through `eeprom_sector_find()`. If no valid record
+ * is found the defaults are returned and nothing is written.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param record Record to load, always in the current version on return.
+ * @param defaults Default record, e.g. a const in flash.
+ * @return The active sector index, `SECTOR_NONE` if no valid record was found, or
+ *         `SECTOR_ERROR` on a bus error, with the defaults in `record` in both cases.
+ */
+uint8_t schema_sector_load(const struct_i2c_handle *i2c, struct_record_t *record, const struct_record_t *defaults);
+
+/**
+ * @brief Writes the record in the current version using wear-leveling.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param record Record to save, version and CRC are filled in.
+ * @param current_sector Index of the currently active sector.
+ * @return The new active sector index.
+ */
+uint8_t schema_sector_write(struct_i2c_handle *i2c, struct_record_t *record, uint8_t current_sector);
+
+#endif // RECORD_SCHEMA_H
@@ -0,0 +1,196 @@
+#include "scrubber.h"
+#include "record_format.h"
+
+static struct_data_t scrub_image;               // Record as read by the current pass
+static uint32_t scrub_offset = 0;               // Bytes of the record verified so far
+static uint8_t scrub_sector = SECTOR_NONE;      // Sector the current pass is reading
+static struct_scrub_stats_t scrub_stats;
+
+#if SCRUB_MAX_AGE_S
+static uint32_t scrub_written = 0;              // Time the active record was last written, never later than the truth
+static uint32_t scrub_stamped = 0;              // Time held by the newest stamp slot
+static uint8_t scrub_slot = 1;                  // Stamp slot holding the newest time
+
+static void scrub_stamp_save(const struct_i2c_handle *i2c, uint32_t time)
+{
+    uint8_t stamp[SCRUB_STAMP_SIZE];
+    uint8_t slot = scrub_slot ^ 1;
+
+    le32_store(&stamp[0], time);
+    record_crc_seal(stamp, sizeof(stamp));
+
+    // Overwrite the older slot, so an interrupted write leaves the previous time intact
+    if (eeprom_bus_write(i2c, (uint16_t)(SCRUB_ADDRESS + slot * SCRUB_STAMP_SIZE), stamp, sizeof(stamp)) == EEPROM_OK)
+    {
+        scrub_slot = slot;
+        scrub_stamped = time;
+    }
+}
+
+// Notes a write of the active record, persisting the time only if the stamp lags far behind
+static void scrub_stamp_update(const struct_i2c_handle *i2c, uint8_t force)
+{
+    uint32_t now = eeprom_rtc_seconds();
+
+    scrub_written = now;
+
+    if (force || now - scrub_stamped >= SCRUB_MAX_AGE_S / 8)
+    {
+        scrub_stamp_save(i2c, now);
+    }
+}
+#endif
+
+void scrub_load(const struct_i2c_handle *i2c)
+{
+    scrub_offset = 0;
+    scrub_sector = SECTOR_NONE;
+    memset(&scrub_stats, 0, sizeof(scrub_stats));
+
+#if SCRUB_MAX_AGE_S
+    uint8_t stamp[SCRUB_STAMP_SIZE];
+    uint8_t found = 0;
+
+    for (uint8_t slot = 0; slot < 2; slot++)
+    {
+        if (eeprom_bus_read(i2c, (uint16_t)(SCRUB_ADDRESS + slot * SCRUB_STAMP_SIZE), stamp, sizeof(stamp)) != EEPROM_OK ||
+            !record_crc_valid(stamp, sizeof(stamp)))
+        {
+            continue;
+        }
+
+        uint32_t time = le32_load(&stamp[0]);
+        if (found && (int32_t)(time - scrub_stamped) <= 0)
+        {
+            continue;
+        }
+
+        scrub_stamped = time;
+        scrub_slot = slot;
+        found = 1;
+    }
+
+    if (!found)
+    {
+        // First boot, the record cannot be older than now
+        scrub_stamp_save(i2c, eeprom_rtc_seconds());
+    }
+
+    // Writes since the stamp may have been too recent to persist, so assume the oldest time
+    scrub_written = scrub_stamped;
+#else
+    (void)i2c;
+#endif
+}
+
+scrub_result_t scrub_check(const struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size, uint8_t current_sector)
+{
+    // Nothing saved yet, the load failed, or the record does not fit the scrub buffer
+    if (current_sector >= sector_count || size > sizeof(scrub_image))
+    {
+        return SCRUB_FINE;
+    }
+
+    // A new active sector means the record was saved since the last step, restart the pass on it
+    if (current_sector != scrub_sector)
+    {
+#if SCRUB_MAX_AGE_S
+        if (scrub_sector != SECTOR_NONE)
+        {
+            scrub_stamp_update(i2c, 0);
+        }
+#endif
+        scrub_sector = current_sector;
+        scrub_offset = 0;
+    }
+
+    uint32_t length = size - scrub_offset;
+    if (length > SCRUB_CHUNK)
+    {
+        length = SCRUB_CHUNK;
+    }
+
+    // A failed read is simply retried at the next step
+    if (eeprom_bus_read(i2c, (uint16_t)(sector_address[current_sector] + scrub_offset),
+                        (uint8_t *)&scrub_image + scrub_offset, length) != EEPROM_OK)
+    {
+        return SCRUB_FINE;
+    }
+
+    scrub_offset += length;
+    if (scrub_offset < size)
+    {
+        return SCRUB_FINE;
+    }
+
+    scrub_offset = 0;
+    scrub_stats.passes++;
+
+    if (!record_crc_valid((uint8_t *)&scrub_image, size) ||
+        (buffer != NULL && memcmp(&scrub_image, buffer, size) != 0))
+    {
+        // Read once more, a record that comes back correct is stored in weak cells
+        if (eeprom_bus_read(i2c, sector_address[current_sector], (uint8_t *)&scrub_image, size) != EEPROM_OK ||
+            !record_crc_valid((uint8_t *)&scrub_image, size) ||
+            (buffer != NULL && memcmp(&scrub_image, buffer, size) != 0))
+        {
+            return SCRUB_CORRUPT;
+        }
+
+        scrub_stats.marginal++;
+        return SCRUB_REFRESH;
+    }
+
+#if SCRUB_MAX_AGE_S
+    if (eeprom_rtc_seconds() - scrub_written >= SCRUB_MAX_AGE_S)
+    {
+        return SCRUB_REFRESH;
+    }
+#endif
+
+    return SCRUB_FINE;
+}
+
+#if !SCRUB_JOURNAL
+uint8_t scrub_step(struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size, uint8_t current_sector)
+{
+    scrub_result_t result = scrub_check(i2c, buffer, size, current_sector);
+
+    if (result == SCRUB_FINE)
+    {
+        return current_sector;
+    }
+
+    if (result == SCRUB_CORRUPT)
+    {
+        // Rewriting a corrupt record would only make it look valid
+        if (buffer == NULL)
+        {
+            scrub_stats.uncorrectable++;
+            return current_sector;
+        }
+
+        memcpy(&scrub_image, buffer, size);
+        scrub_stats.corrected++;
+    }
+
+    uint8_t sector = eeprom_sector_write(i2c, (uint8_t *)&scrub_image, size, current_sector);
+
+    // An unchanged sector means the write failed, the next pass tries again
+    if (sector != current_sector)
+    {
+        scrub_stats.refreshes++;
+        scrub_sector = sector;
+#if SCRUB_MAX_AGE_S
+        scrub_stamp_update(i2c, 1);
+#endif
+    }
+
+    return sector;
+}
+#endif
+
+const struct_scrub_stats_t *scrub_stats_get(void)
+{
+    return &scrub_stats;
+}
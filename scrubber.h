@@ -0,0 +1,107 @@
+/**
+ * @file scrubber.h
+ * @brief Background Scrubbing and Retention Refresh
+ *
+ * EEPROM cells slowly lose charge, faster at high temperature, and a decayed record is
+ * otherwise only noticed by the next `eeprom_sector_load()`, when it may be too late.
+ * `scrub_step()` is meant for idle time: each call reads at most `SCRUB_CHUNK` bytes of
+ * the active record, so verification is spread out and no step holds the bus for long.
+ * After a full pass the record is checked against its CRC and, if given, the RAM copy.
+ *
+ * The record is rewritten to the next sector, which refreshes its charge, when
+ * - it failed its CRC once but read back correctly, a sign of a marginal cell,
+ * - it is corrupt or differs from the RAM copy, which then corrects it, or
+ * - it has not been rewritten for `SCRUB_MAX_AGE_S` seconds.
+ *
+ * The time of the last write is kept in two small stamp slots. It is updated when the
+ * scrubber sees the active sector change, at most every `SCRUB_MAX_AGE_S / 8`, so
+ * frequent saves do not wear the stamp area. A stamp that lags behind only makes the
+ * record look older, so the age is never underestimated. With `SCRUB_MAX_AGE_S` set
+ * to 0 no stamp is kept.
+ *
+ * Only the wear-levelled record is scrubbed. The journal, queue, pack, time-series, hash
+ * and table regions have their own layouts and are checked entry by entry by their own
+ * modules, which know how to rewrite what they find. A region that is written once and
+ * kept for years, such as a sorted table, should be rewritten by its owner within the
+ * retention period.
+ *
+ * When the record is the snapshot of a delta journal, moving it with
+ * `eeprom_sector_write()` would leave the journal header naming the old sector, and every
+ * delta saved since the snapshot would be dropped at the next boot. Set `SCRUB_JOURNAL`
+ * to 1 in that case: `scrub_step()` is then not available, and the snapshot is checked
+ * with `scrub_check()` and rewritten by `journal_compact()`, which moves the journal along
+ * with it. The check only uses the CRC, since the snapshot lags the record by its deltas.
+ *
+ * @note Configure `SCRUB_ADDRESS`, `SCRUB_CHUNK` and `SCRUB_MAX_AGE_S` and implement
+ *       `eeprom_rtc_seconds()` in `config.h`.
+ *
+ * Usage:
+ * - Call `scrub_load()` once at boot.
+ * - Call `scrub_step()` from the idle loop and keep the sector it returns.
+ * - With `SCRUB_JOURNAL`, call `scrub_check()` with the snapshot sector instead and
+ *   `journal_compact()` with the committed record whenever it does not return `SCRUB_FINE`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef SCRUBBER_H
+#define SCRUBBER_H
+
+#include "wear_levelling.h"
+
+#define SCRUB_STAMP_SIZE    6   ///< Time (4) + CRC (2)
+
+// Outcome of a scrub check
+typedef enum {
+    SCRUB_FINE = 0,             ///< Pass not complete yet, or the record needs nothing
+    SCRUB_REFRESH,              ///< Record intact but marginal or old, rewrite it
+    SCRUB_CORRUPT               ///< Record corrupt or unlike the RAM copy, rewrite it from a good copy
+} scrub_result_t;
+
+// Scrubber statistics since boot
+typedef struct {
+    uint32_t passes;            ///< Complete verifications of the active record
+    uint32_t marginal;          ///< Records that failed once and read back correctly
+    uint32_t corrected;         ///< Records restored from the RAM copy by `scrub_step()`
+    uint32_t uncorrectable;     ///< Corrupt records `scrub_step()` had no RAM copy to restore from
+    uint32_t refreshes;         ///< Records rewritten by `scrub_step()`, for any reason
+} struct_scrub_stats_t;
+
+/**
+ * @brief Restores the time of the last write.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ */
+void scrub_load(const struct_i2c_handle *i2c);
+
+/**
+ * @brief Verifies the next chunk of the active record without writing anything.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer RAM copy of the record as last saved, or NULL to check the CRC only.
+ * @param size Size of the record, at most `sizeof(struct_data_t)`, or nothing is checked.
+ * @param current_sector Index of the currently active sector.
+ * @return What the record needs once a full pass is complete, `SCRUB_FINE` until then.
+ */
+scrub_result_t scrub_check(const struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size, uint8_t current_sector);
+
+#if !SCRUB_JOURNAL
+/**
+ * @brief Verifies the next chunk of the active record and refreshes it after a full pass if needed.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer RAM copy of the record as last saved, used to correct it, or NULL to check the CRC only.
+ * @param size Size of the record, at most `sizeof(struct_data_t)`, or nothing is scrubbed.
+ * @param current_sector Index of the currently active sector.
+ * @return The active sector index, changed if the record was refreshed.
+ */
+uint8_t scrub_step(struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size, uint8_t current_sector);
+#endif
+
+/**
+ * @brief Returns the scrubber statistics.
+ */
+const struct_scrub_stats_t *scrub_stats_get(void);
+
+#endif // SCRUBBER_H
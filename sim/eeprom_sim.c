@@ -0,0 +1,385 @@
+#include "eeprom_sim.h"
+#include "sim_trace.h"
+#include <string.h>
+
+#define SIM_BITS_PER_BYTE   9           ///< 8 data bits and the ACK bit
+#define SIM_BITS_PER_START  1           ///< START, repeated START or STOP condition
+
+#if EEPROM_ASYNC_READ
+#define SIM_POLL_NS         1000        ///< CPU time of one `eeprom_read_done()` poll
+
+// Asynchronous read in flight, each handle being a controller of its own
+typedef struct {
+    const struct_i2c_handle *i2c;       ///< Controller, NULL if the slot is free
+    uint16_t address;
+    uint8_t *data;
+    uint32_t size;
+    uint64_t done_at;                   ///< Virtual time the transfer ends
+} struct_sim_async_t;
+
+static struct_sim_async_t sim_async[MULTI_BUS_MAX];
+#endif
+
+static const struct_sim_config_t sim_default_config =
+{
+    .bus_hz = 400000,
+    .write_cycle_us = 5000,
+    .page_size = EEPROM_PAGE_SIZE,
+    .crc_ns_per_byte = 20,
+    .nack_when_busy = 0
+};
+
+static struct_sim_config_t sim_config;
+static struct_sim_stats_t sim_stats;
+static uint8_t sim_mem[SIM_MEMORY_SIZE];
+static uint8_t sim_fram[SIM_MEMORY_SIZE];
+static uint32_t sim_wear[SIM_MEMORY_SIZE];  // Write cycles per page, indexed by page number
+static uint64_t sim_now = 0;
+static uint64_t sim_busy_until = 0;     // End of the current write cycle
+
+// Bus time of `bytes` bytes framed by `conditions` START/STOP conditions
+static uint64_t sim_bus_ns(uint32_t bytes, uint32_t conditions)
+{
+    return ((uint64_t)bytes * SIM_BITS_PER_BYTE + conditions * SIM_BITS_PER_START) * 1000000000ull / sim_config.bus_hz;
+}
+
+// ACK polls the device until its write cycle has ended
+static void sim_wait_ready(uint16_t address)
+{
+    if (sim_now >= sim_busy_until)
+    {
+        return;
+    }
+
+    uint64_t start = sim_now;
+    uint64_t poll = sim_bus_ns(1, 2);       // START, device address NACKed, STOP
+    uint32_t polls = 0;
+
+    while (sim_now < sim_busy_until)
+    {
+        sim_now += poll;
+        polls++;
+    }
+
+    sim_stats.polls += polls;
+    sim_stats.poll_ns += sim_now - start;
+    sim_trace_span(SIM_TRACK_BUS, "ack poll", start, sim_now - start, address, polls);
+}
+
+static void sim_transfer(const char *name, uint16_t address, uint32_t bytes, uint32_t conditions, uint32_t size)
+{
+    uint64_t duration = sim_bus_ns(bytes, conditions);
+
+    sim_trace_span(SIM_TRACK_BUS, name, sim_now, duration, address, size);
+    sim_now += duration;
+    sim_stats.bus_ns += duration;
+    sim_stats.bus_bytes += bytes;
+}
+
+void sim_init(const struct_sim_config_t *config)
+{
+    sim_config = (config != NULL) ? *config : sim_default_config;
+    sim_stats = (struct_sim_stats_t){0};
+    sim_now = 0;
+    sim_busy_until = 0;
+    memset(sim_mem, EEPROM_BLANK_VALUE, sizeof(sim_mem));
+    memset(sim_fram, 0, sizeof(sim_fram));
+    memset(sim_wear, 0, sizeof(sim_wear));
+#if EEPROM_ASYNC_READ
+    memset(sim_async, 0, sizeof(sim_async));
+#endif
+}
+
+uint64_t sim_time_ns(void)
+{
+    return sim_now;
+}
+
+void sim_advance(uint64_t ns)
+{
+    sim_now += ns;
+}
+
+void sim_settle(void)
+{
+    if (sim_now < sim_busy_until)
+    {
+        sim_now = sim_busy_until;
+    }
+}
+
+uint8_t *sim_memory(void)
+{
+    return sim_mem;
+}
+
+const struct_sim_stats_t *sim_stats_get(void)
+{
+    return &sim_stats;
+}
+
+uint32_t sim_wear_max(void)
+{
+    uint32_t most = 0;
+
+    for (uint32_t page = 0; page < SIM_MEMORY_SIZE / sim_config.page_size; page++)
+    {
+        if (sim_wear[page] > most)
+        {
+            most = sim_wear[page];
+        }
+    }
+
+    return most;
+}
+
+void eeprom_write(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size)
+{
+    (void)i2c;
+
+    // The device wraps within a page, so the driver splits writes at page boundaries
+    while (size > 0)
+    {
+        uint32_t chunk = sim_config.page_size - (address % sim_config.page_size);
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        sim_wait_ready(address);
+        sim_transfer("write", address, 3 + chunk, 2, chunk);   // Device address, 2 address bytes, data
+
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            sim_mem[(uint16_t)(address + i)] = data[i];
+        }
+
+        sim_busy_until = sim_now + (uint64_t)sim_config.write_cycle_us * 1000;
+        sim_trace_span(SIM_TRACK_DEVICE, "write cycle", sim_now, sim_busy_until - sim_now, address, chunk);
+        sim_stats.page_writes++;
+        sim_wear[address / sim_config.page_size]++;
+
+        address = (uint16_t)(address + chunk);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void eeprom_read(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size)
+{
+    (void)i2c;
+
+    sim_wait_ready(address);
+    sim_transfer("read", address, 4 + size, 3, size);         // Address write, repeated START, device address, data
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        data[i] = sim_mem[(uint16_t)(address + i)];
+    }
+
+    sim_stats.reads++;
+}
+
+// FRAM is a separate device on the same bus: no write cycle, no page limit, no need to wait for the EEPROM
+void fram_write(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size)
+{
+    (void)i2c;
+
+    sim_transfer("fram write", address, 3 + size, 2, size);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        sim_fram[(uint16_t)(address + i)] = data[i];
+    }
+}
+
+void fram_read(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size)
+{
+    (void)i2c;
+
+    sim_transfer("fram read", address, 4 + size, 3, size);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        data[i] = sim_fram[(uint16_t)(address + i)];
+    }
+}
+
+uint16_t calculate_crc16(const uint8_t *data, uint32_t length)
+{
+    uint16_t crc = 0xFFFF;                  // CRC-16/CCITT-FALSE, matches CRC16_POLYNOMIAL 0x1021
+    uint64_t duration = (uint64_t)length * sim_config.crc_ns_per_byte;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLYNOMIAL) : (uint16_t)(crc << 1);
+        }
+    }
+
+    sim_trace_span(SIM_TRACK_CPU, "crc16", sim_now, duration, 0, length);
+    sim_now += duration;
+    sim_stats.cpu_ns += duration;
+
+    return crc;
+}
+
+#if EEPROM_BUS_RETRY
+// Sends the device address alone and returns 1 if it was NACKed because of a write cycle
+static uint8_t sim_nack_busy(uint16_t address)
+{
+    uint64_t poll = sim_bus_ns(1, 2);       // START, device address NACKed, STOP
+
+    if (!sim_config.nack_when_busy || sim_now >= sim_busy_until)
+    {
+        return 0;
+    }
+
+    sim_trace_span(SIM_TRACK_BUS, "nack", sim_now, poll, address, 0);
+    sim_now += poll;
+    sim_stats.polls++;
+    sim_stats.poll_ns += poll;
+
+    return 1;
+}
+
+eeprom_status_t eeprom_write_status(const struct_i2c_handle *i2c, uint16_t address, const uint8_t *data, uint32_t size)
+{
+    if (sim_nack_busy(address))
+    {
+        return EEPROM_ERR_NACK;
+    }
+
+    eeprom_write(i2c, address, data, size);
+    return EEPROM_OK;
+}
+
+eeprom_status_t eeprom_read_status(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size)
+{
+    if (sim_nack_busy(address))
+    {
+        return EEPROM_ERR_NACK;
+    }
+
+    eeprom_read(i2c, address, data, size);
+    return EEPROM_OK;
+}
+
+void eeprom_bus_recover(const struct_i2c_handle *i2c, uint8_t pulses)
+{
+    uint64_t duration = ((uint64_t)pulses + SIM_BITS_PER_START) * 1000000000ull / sim_config.bus_hz;
+
+    (void)i2c;
+    sim_trace_span(SIM_TRACK_BUS, "recover", sim_now, duration, 0, pulses);
+    sim_now += duration;
+}
+#endif
+
+#if EEPROM_BATCH
+// The whole sequence runs back to back, as a DMA-chaining driver would
+uint8_t eeprom_submit_batch(const struct_i2c_handle *i2c, const struct_eeprom_op_t *ops, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (ops[i].type == EEPROM_OP_READ)
+        {
+            eeprom_read(i2c, ops[i].address, ops[i].data, ops[i].size);
+        }
+        else if (ops[i].type == EEPROM_OP_WRITE)
+        {
+            eeprom_write(i2c, ops[i].address, ops[i].data, ops[i].size);
+        }
+        else
+        {
+            sim_wait_ready(ops[i].address);
+        }
+    }
+
+    return count;
+}
+#endif
+
+#if EEPROM_ASYNC_READ
+// The transfer runs on the controller while the caller goes on, so it is charged to the bus
+// statistics but not to the clock; the caller's polls move the clock until it has ended
+eeprom_status_t eeprom_read_start(const struct_i2c_handle *i2c, uint16_t address, uint8_t *data, uint32_t size)
+{
+    struct_sim_async_t *slot = NULL;
+
+    for (uint8_t i = 0; i < MULTI_BUS_MAX; i++)
+    {
+        if (sim_async[i].i2c == i2c)
+        {
+            return EEPROM_BUSY;
+        }
+
+        if (slot == NULL && sim_async[i].i2c == NULL)
+        {
+            slot = &sim_async[i];
+        }
+    }
+
+    if (slot == NULL)
+    {
+        return EEPROM_ERR_BUS;
+    }
+
+    uint64_t start = (sim_now > sim_busy_until) ? sim_now : sim_busy_until;
+    uint64_t duration = sim_bus_ns(4 + size, 3);
+
+    *slot = (struct_sim_async_t){ i2c, address, data, size, start + duration };
+    sim_trace_span(SIM_TRACK_BUS, "async read", start, duration, address, size);
+    sim_stats.bus_ns += duration;
+    sim_stats.bus_bytes += 4 + size;
+    sim_stats.reads++;
+
+    return EEPROM_OK;
+}
+
+eeprom_status_t eeprom_read_done(const struct_i2c_handle *i2c)
+{
+    for (uint8_t i = 0; i < MULTI_BUS_MAX; i++)
+    {
+        struct_sim_async_t *slot = &sim_async[i];
+
+        if (slot->i2c != i2c)
+        {
+            continue;
+        }
+
+        if (sim_now < slot->done_at)
+        {
+            sim_now += SIM_POLL_NS;
+            sim_stats.cpu_ns += SIM_POLL_NS;
+            return EEPROM_BUSY;
+        }
+
+        for (uint32_t j = 0; j < slot->size; j++)
+        {
+            slot->data[j] = sim_mem[(uint16_t)(slot->address + j)];
+        }
+
+        slot->i2c = NULL;
+        return EEPROM_OK;
+    }
+
+    return EEPROM_ERR_BUS;
+}
+#endif
+
+#if EEPROM_BUS_RETRY || LATENCY_HIST
+uint32_t eeprom_time_us(void)
+{
+    return (uint32_t)(sim_now / 1000);
+}
+#endif
+
+#if SCRUB_MAX_AGE_S
+uint32_t eeprom_rtc_seconds(void)
+{
+    return (uint32_t)(sim_now / 1000000000ull);
+}
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file eeprom_sim.h
+ * @brief Host Simulator of an I2C EEPROM in Virtual Time
+ *
+ * Implements the HAL hooks of `config.h`, including the FRAM hooks, on the host so the
+ * library can run unmodified on a PC. Time is virtual: every transfer advances the clock
+ * by its I2C bit time, every page write starts an internal write cycle during which the
+ * device does not acknowledge, and the next EEPROM transfer ACK-polls until the cycle
+ * ends, as the real driver would. With `nack_when_busy` set, the status hooks of
+ * `EEPROM_BUS_RETRY` instead reply NACK while the device is busy, so the polling of
+ * `eeprom_bus.c` is exercised. CRC computation is charged a configurable CPU cost
+ * per byte. With `EEPROM_ASYNC_READ` every handle acts as a controller of its own reading
+ * the same memory, so the reads of `eeprom_multi_load()` overlap in virtual time.
+ *
+ * Every transfer, write cycle, polling period and CRC run is reported to `sim_trace.h`,
+ * so opening the trace in chrome://tracing or ui.perfetto.dev shows where the time of a
+ * save goes.
+ *
+ * Build on the host from the repository root, for example:
+ * `gcc -std=c11 -I. -Isim wear_levelling.c eeprom_bus.c delta_journal.c record_diff.c
+ *  crc16_incremental.c sim/eeprom_sim.c sim/sim_trace.c sim/sim_main.c -o eeprom_sim`
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef EEPROM_SIM_H
+#define EEPROM_SIM_H
+
+#include "config.h"
+
+#define SIM_MEMORY_SIZE     0x10000     ///< Simulated device size, the whole 16-bit address space
+
+// Device and host timing model
+typedef struct {
+    uint32_t bus_hz;            ///< SCL frequency, e.g. 400000
+    uint32_t write_cycle_us;    ///< Internal write cycle time (tWR) per page write
+    uint16_t page_size;         ///< Page write buffer size, writes are split at page boundaries
+    uint32_t crc_ns_per_byte;   ///< CPU time charged per byte passed to `calculate_crc16()`
+    uint8_t nack_when_busy;     ///< 1 to have the status hooks NACK during a write cycle instead of waiting
+} struct_sim_config_t;
+
+// Totals since `sim_init()`
+typedef struct {
+    uint32_t reads;             ///< Read transfers
+    uint32_t page_writes;       ///< Page writes, each one write cycle
+    uint32_t bus_bytes;         ///< Bytes clocked on the bus including addressing
+    uint32_t polls;             ///< ACK polls sent while the device was busy
+    uint64_t bus_ns;            ///< Time spent transferring
+    uint64_t poll_ns;           ///< Time spent ACK polling
+    uint64_t cpu_ns;            ///< Time charged for CPU work
+} struct_sim_stats_t;
+
+/**
+ * @brief Resets the clock, the statistics and the memory to blank.
+ *
+ * @param config Timing model, or NULL for a 24C256 at 400 kHz.
+ */
+void sim_init(const struct_sim_config_t *config);
+
+/**
+ * @brief Returns the virtual time in nanoseconds.
+ */
+uint64_t sim_time_ns(void);
+
+/**
+ * @brief Advances the virtual time, e.g. for CPU work done by the driver.
+ *
+ * @param ns Nanoseconds to add.
+ */
+void sim_advance(uint64_t ns);
+
+/**
+ * @brief Waits until the current write cycle has ended, without polling the bus.
+ */
+void sim_settle(void);
+
+/**
+ * @brief Returns the simulated memory, for dumps and fault injection.
+ */
+uint8_t *sim_memory(void);
+
+/**
+ * @brief Returns the totals since `sim_init()`.
+ */
+const struct_sim_stats_t *sim_stats_get(void);
+
+/**
+ * @brief Returns the write cycles of the most worn page since `sim_init()`.
+ */
+uint32_t sim_wear_max(void);
+
+#endif // EEPROM_SIM_H
@@ -0,0 +1,341 @@
+/**
+ * @file explorer.c
+ * @brief Host Design-Space Explorer for Layout and Save Policy
+ *
+ * Replays a save workload on the simulator once per combination of
+ * - sector count (placed by `layout_plan()`, from 3 up to `NUMBER_OF_SECTORS`),
+ * - flush interval: saves cached in RAM with `DURABILITY_CACHED` before one is written,
+ * - coalescing window: the longest a cached save may wait before it is written,
+ * - integrity: written, or verified by read-back with `DURABILITY_VERIFIED`,
+ * and reports save latency, boot time, RAM, saves at risk on reset and lifetime. The
+ * configurations no other one of the same integrity beats on every metric are marked as
+ * Pareto-optimal. Lifetime is the time the workload covers, scaled by the endurance left
+ * on the most worn page; beyond `EXPLORER_SERVICE_DAYS` it buys nothing, so longer ones
+ * compare as equal. Of configurations with equal metrics only the first, the one with the
+ * fewest sectors and the shortest flush and window, is marked.
+ *
+ * Each configuration runs the real `wear_levelling.c` in its own forked process, so they
+ * use all cores and the library's static state never leaks between them.
+ *
+ * The workload file holds one save per line: the time since the previous save in ms.
+ * Without a file a mixed workload is replayed: a save a minute, and every ten minutes a
+ * burst of 20 saves 20 ms apart.
+ *
+ * Usage: `explorer [workload.txt]`
+ *
+ * Build on the host (POSIX) from the repository root:
+ * `gcc -std=c11 -O2 -I. -Isim wear_levelling.c eeprom_bus.c durability.c layout_planner.c
+ *  sim/eeprom_sim.c sim/sim_trace.c sim/explorer.c -o explorer`
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "eeprom_sim.h"
+#include "durability.h"
+#include "layout_planner.h"
+#include "record_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define EXPLORER_ENDURANCE      1000000ul   ///< Write cycles a page is rated for
+#define EXPLORER_MAX_SAVES      100000      ///< Saves read from a workload file
+#define EXPLORER_SYNTHETIC      2000        ///< Saves of the synthetic workload
+#define EXPLORER_SERVICE_DAYS   3650.0      ///< Service life the device must reach, 10 years
+
+static const uint32_t explorer_flush[] = { 1, 4, 16 };         // Saves per write
+static const uint32_t explorer_window_ms[] = { 0, 100, 1000 };  // Coalescing window, 0 for none
+static const durability_t explorer_integrity[] = { DURABILITY_WRITTEN, DURABILITY_VERIFIED };
+
+// Configuration of one run
+typedef struct {
+    uint8_t sectors;
+    uint32_t flush;
+    uint32_t window_ms;
+    durability_t integrity;
+} struct_explorer_config_t;
+
+// Metrics of one run
+typedef struct {
+    double save_us;             ///< Mean time a save call takes
+    double save_max_us;         ///< Longest save call
+    double boot_us;             ///< Slowest load, over every active sector
+    uint32_t ram;               ///< Address tables plus the record cache
+    uint32_t at_risk;           ///< Most saves held in RAM at once, lost on reset
+    double lifetime_days;       ///< Time until the most worn page reaches its rated endurance
+} struct_explorer_result_t;
+
+static uint32_t *explorer_delay_ms;     // Workload, time before each save
+static uint32_t explorer_saves;
+
+static void explorer_workload(const char *path)
+{
+    explorer_delay_ms = malloc(EXPLORER_MAX_SAVES * sizeof(uint32_t));
+
+    if (path == NULL)
+    {
+        for (explorer_saves = 0; explorer_saves < EXPLORER_SYNTHETIC; explorer_saves++)
+        {
+            uint32_t step = explorer_saves % 30;
+
+            // Nine single saves a minute apart, then a burst of 20 and a minute of quiet
+            explorer_delay_ms[explorer_saves] = (step < 10) ? 60000 : 20;
+        }
+        return;
+    }
+
+    FILE *file = fopen(path, "r");
+    char line[64];
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        exit(1);
+    }
+
+    explorer_saves = 0;
+    while (explorer_saves < EXPLORER_MAX_SAVES && fgets(line, sizeof(line), file) != NULL)
+    {
+        if (line[0] != '#' && line[0] != '\n')
+        {
+            explorer_delay_ms[explorer_saves++] = (uint32_t)strtoul(line, NULL, 0);
+        }
+    }
+
+    fclose(file);
+}
+
+// Writes the newest record with the configured integrity
+static uint8_t explorer_write(struct_i2c_handle *i2c, struct_data_t *record, uint8_t sector, durability_t integrity)
+{
+    return eeprom_sector_write_durable(i2c, (uint8_t *)record, sizeof(*record), sector, integrity);
+}
+
+static struct_explorer_result_t explorer_run(const struct_explorer_config_t *config)
+{
+    struct_explorer_result_t result = {0};
+    struct_i2c_handle i2c;
+    struct_data_t record = {0};
+    uint8_t sector = SECTOR_NONE;
+    uint32_t pending = 0;
+    uint64_t deadline = 0;              // When the oldest cached save must be written
+    uint64_t total_ns = 0;
+    uint64_t workload_ms = 0;           // Time the workload covers in the field
+    uint8_t cached = (config->flush > 1);
+
+    sim_init(NULL);
+    layout_plan(sizeof(record), NULL, 0);
+    sector_count = config->sectors;
+
+    for (uint32_t i = 0; i < explorer_saves; i++)
+    {
+        uint64_t idle = (uint64_t)explorer_delay_ms[i] * 1000000ull;
+
+        workload_ms += explorer_delay_ms[i];
+
+        // A periodic task writes a cached save once the window is over, outside any save call
+        if (pending > 0 && config->window_ms > 0 && sim_time_ns() + idle >= deadline)
+        {
+            uint64_t now = sim_time_ns();
+
+            sim_advance((deadline > now) ? deadline - now : 0);
+            idle -= (deadline > now) ? deadline - now : 0;
+            sector = explorer_write(&i2c, &record, sector, config->integrity);
+            pending = 0;
+        }
+
+        sim_advance(idle);
+
+        uint64_t call = sim_time_ns();
+
+        record.data[i % sizeof(record.data)]++;
+        record_crc_seal((uint8_t *)&record, sizeof(record));
+
+        if (cached && ++pending < config->flush)
+        {
+            if (pending == 1)
+            {
+                deadline = call + (uint64_t)config->window_ms * 1000000ull;
+            }
+            eeprom_sector_write_durable(&i2c, (uint8_t *)&record, sizeof(record), sector, DURABILITY_CACHED);
+        }
+        else
+        {
+            sector = explorer_write(&i2c, &record, sector, config->integrity);
+            pending = 0;
+        }
+
+        uint64_t duration = sim_time_ns() - call;
+
+        total_ns += duration;
+        result.save_max_us = (duration / 1e3 > result.save_max_us) ? duration / 1e3 : result.save_max_us;
+        result.at_risk = (pending > result.at_risk) ? pending : result.at_risk;
+    }
+
+    if (pending > 0)
+    {
+        sector = explorer_write(&i2c, &record, sector, config->integrity);
+    }
+
+    uint32_t wear = sim_wear_max();
+
+    // The scan time depends on which sector is active, so boot once with each one active
+    for (uint8_t i = 0; i < config->sectors; i++)
+    {
+        sector = eeprom_sector_write(&i2c, (uint8_t *)&record, sizeof(record), sector);
+        sim_settle();
+
+        uint64_t boot = sim_time_ns();
+        eeprom_sector_load(&i2c, (uint8_t *)&record, sizeof(record));
+
+        double boot_us = (sim_time_ns() - boot) / 1e3;
+        result.boot_us = (boot_us > result.boot_us) ? boot_us : result.boot_us;
+    }
+
+    result.save_us = total_ns / 1e3 / explorer_saves;
+    result.ram = 4u * config->sectors + (cached ? (uint32_t)sizeof(record) : 0);
+    result.lifetime_days = workload_ms / 1e3 * EXPLORER_ENDURANCE / (wear ? wear : 1) / 86400.0;
+
+    return result;
+}
+
+// Lifetime as far as it matters, the service life is all the device has to reach
+static double explorer_lifetime(const struct_explorer_result_t *result)
+{
+    return (result->lifetime_days < EXPLORER_SERVICE_DAYS) ? result->lifetime_days : EXPLORER_SERVICE_DAYS;
+}
+
+// Returns 1 if `a` is at least as good as `b` on every metric and better on one, or equal on
+// all of them and listed first (`simpler`). Integrity is a requirement rather than a cost to
+// trade, so only runs of the same integrity are compared.
+static uint8_t explorer_dominates(const struct_explorer_config_t *config_a, const struct_explorer_config_t *config_b,
+                                  const struct_explorer_result_t *a, const struct_explorer_result_t *b, uint8_t simpler)
+{
+    if (config_a->integrity != config_b->integrity)
+    {
+        return 0;
+    }
+
+    double lifetime_a = explorer_lifetime(a);
+    double lifetime_b = explorer_lifetime(b);
+    uint8_t not_worse = a->save_us <= b->save_us && a->boot_us <= b->boot_us && a->ram <= b->ram &&
+                        a->at_risk <= b->at_risk && lifetime_a >= lifetime_b;
+    uint8_t better = a->save_us < b->save_us || a->boot_us < b->boot_us || a->ram < b->ram ||
+                     a->at_risk < b->at_risk || lifetime_a > lifetime_b;
+
+    return not_worse && (better || simpler);
+}
+
+int main(int argc, char **argv)
+{
+    explorer_workload((argc > 1) ? argv[1] : NULL);
+
+    if (explorer_saves == 0)
+    {
+        fprintf(stderr, "empty workload\n");
+        return 1;
+    }
+
+    uint8_t planned = layout_plan(sizeof(struct_data_t), NULL, 0);
+    uint32_t count = 0;
+    struct_explorer_config_t configs[256];
+
+    // The wear levelling needs 3 sectors or more, see wear_levelling.c
+    for (uint8_t sectors = 3; sectors <= planned && sectors >= 3; sectors = (sectors < 4) ? sectors + 1 : sectors * 2)
+    {
+        for (uint32_t f = 0; f < sizeof(explorer_flush) / sizeof(explorer_flush[0]); f++)
+        {
+            for (uint32_t w = 0; w < sizeof(explorer_window_ms) / sizeof(explorer_window_ms[0]); w++)
+            {
+                // A window only matters when saves are cached
+                if (explorer_flush[f] == 1 && w > 0)
+                {
+                    continue;
+                }
+
+                for (uint32_t k = 0; k < sizeof(explorer_integrity) / sizeof(explorer_integrity[0]) && count < 256; k++)
+                {
+                    configs[count++] = (struct_explorer_config_t){ sectors, explorer_flush[f], explorer_window_ms[w], explorer_integrity[k] };
+                }
+            }
+        }
+    }
+
+    // One process per configuration, at most one per core at a time
+    struct_explorer_result_t results[256];
+    pid_t pids[256];
+    int pipes[256];
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t started = 0;
+    uint32_t running = 0;
+
+    while (started < count || running > 0)
+    {
+        if (started < count && running < (uint32_t)((jobs > 0) ? jobs : 1))
+        {
+            int fds[2];
+
+            if (pipe(fds) != 0)
+            {
+                perror("pipe");
+                return 1;
+            }
+
+            pids[started] = fork();
+            if (pids[started] == 0)
+            {
+                struct_explorer_result_t result = explorer_run(&configs[started]);
+
+                close(fds[0]);
+                _exit(write(fds[1], &result, sizeof(result)) == (ssize_t)sizeof(result) ? 0 : 1);
+            }
+
+            close(fds[1]);
+            pipes[started++] = fds[0];
+            running++;
+            continue;
+        }
+
+        int status;
+        pid_t done = wait(&status);
+
+        for (uint32_t i = 0; i < started; i++)
+        {
+            if (pids[i] == done)
+            {
+                if (read(pipes[i], &results[i], sizeof(results[i])) != (ssize_t)sizeof(results[i]))
+                {
+                    fprintf(stderr, "configuration %lu failed\n", (unsigned long)i);
+                    return 1;
+                }
+                close(pipes[i]);
+                running--;
+            }
+        }
+    }
+
+    printf("%lu saves, %lu configurations, * = Pareto-optimal for its integrity\n\n", (unsigned long)explorer_saves, (unsigned long)count);
+    printf("  sectors flush window_ms integrity  save_us  max_us  boot_us  ram  at_risk  lifetime_days\n");
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t optimal = 1;
+
+        for (uint32_t j = 0; j < count && optimal; j++)
+        {
+            optimal = !explorer_dominates(&configs[j], &configs[i], &results[j], &results[i], j < i);
+        }
+
+        printf("%c %7u %5lu %9lu %-9s %8.1f %7.1f %8.1f %4lu %8lu %14.0f\n", optimal ? '*' : ' ',
+               configs[i].sectors, (unsigned long)configs[i].flush, (unsigned long)configs[i].window_ms,
+               (configs[i].integrity == DURABILITY_VERIFIED) ? "verified" : "written",
+               results[i].save_us, results[i].save_max_us, results[i].boot_us, (unsigned long)results[i].ram,
+               (unsigned long)results[i].at_risk, results[i].lifetime_days);
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file sim_main.c
+ * @brief Host Simulator Driver
+ *
+ * Boots a blank simulated EEPROM, then saves a changing record a number of times through
+ * `eeprom_sector_write()` and through the delta journal, tracing every call.
+ *
+ * Usage: `eeprom_sim [trace.json] [saves]`
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#include "eeprom_sim.h"
+#include "sim_trace.h"
+#include "delta_journal.h"
+#include "record_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Prints the cost of a phase from the statistics taken at its start
+static void sim_report(const char *name, const struct_sim_stats_t *before, uint64_t start_ns, uint32_t saves)
+{
+    const struct_sim_stats_t *stats = sim_stats_get();
+
+    printf("%-8s %4lu saves  %8.3f ms/save  %5lu page writes  bus %8.3f ms  polling %8.3f ms  cpu %6.3f ms\n",
+           name, (unsigned long)saves, (sim_time_ns() - start_ns) / 1e6 / saves,
+           (unsigned long)(stats->page_writes - before->page_writes), (stats->bus_ns - before->bus_ns) / 1e6,
+           (stats->poll_ns - before->poll_ns) / 1e6, (stats->cpu_ns - before->cpu_ns) / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : "trace.json";
+    uint32_t saves = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 8;
+    struct_i2c_handle i2c;
+    struct_data_t record = {0};
+    struct_data_t committed;
+    struct_journal_t journal;
+    struct_sim_stats_t before;
+    uint64_t start;
+
+    if (saves == 0)
+    {
+        saves = 1;
+    }
+
+    sim_init(NULL);
+
+    if (!sim_trace_open(path))
+    {
+        fprintf(stderr, "cannot create %s\n", path);
+        return 1;
+    }
+
+    start = sim_time_ns();
+    uint8_t active_sector = eeprom_sector_load(&i2c, (uint8_t *)&record, sizeof(record));
+    sim_trace_span(SIM_TRACK_CALL, "eeprom_sector_load", start, sim_time_ns() - start, 0, sizeof(record));
+    sim_settle();
+
+    // Full record rewrite on every save
+    before = *sim_stats_get();
+    start = sim_time_ns();
+    for (uint32_t i = 0; i < saves; i++)
+    {
+        uint64_t call = sim_time_ns();
+
+        record.data[i % sizeof(record.data)]++;
+        record_crc_seal((uint8_t *)&record, sizeof(record));
+        active_sector = eeprom_sector_write(&i2c, (uint8_t *)&record, sizeof(record), active_sector);
+        sim_trace_span(SIM_TRACK_CALL, "eeprom_sector_write", call, sim_time_ns() - call, 0, sizeof(record));
+    }
+    sim_settle();
+    sim_report("sector", &before, start, saves);
+
+    // Same changes through the delta journal, on top of the sectors written above
+    start = sim_time_ns();
+    journal_load(&i2c, &journal, (uint8_t *)&record, sizeof(record));
+    committed = record;
+    sim_trace_span(SIM_TRACK_CALL, "journal_load", start, sim_time_ns() - start, JOURNAL_ADDRESS, sizeof(record));
+    sim_settle();
+
+    before = *sim_stats_get();
+    start = sim_time_ns();
+    for (uint32_t i = 0; i < saves; i++)
+    {
+        uint64_t call = sim_time_ns();
+
+        record.data[i % sizeof(record.data)]++;
+        journal_save(&i2c, &journal, (uint8_t *)&record, (uint8_t *)&committed, sizeof(record));
+        sim_trace_span(SIM_TRACK_CALL, "journal_save", call, sim_time_ns() - call, JOURNAL_ADDRESS, sizeof(record));
+    }
+    sim_settle();
+    sim_report("journal", &before, start, saves);
+
+    sim_trace_close();
+    printf("trace written to %s\n", path);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "sim_trace.h"
+#include <stdio.h>
+
+static FILE *trace_file = NULL;
+static uint8_t trace_first = 1;
+
+static const char *const trace_track_names[] =
+{
+    [SIM_TRACK_CALL]   = "Library",
+    [SIM_TRACK_CPU]    = "CPU",
+    [SIM_TRACK_BUS]    = "I2C bus",
+    [SIM_TRACK_DEVICE] = "EEPROM write cycle"
+};
+
+static void sim_trace_separator(void)
+{
+    if (!trace_first)
+    {
+        fputs(",\n", trace_file);
+    }
+
+    trace_first = 0;
+}
+
+uint8_t sim_trace_open(const char *path)
+{
+    trace_file = fopen(path, "w");
+    if (trace_file == NULL)
+    {
+        return 0;
+    }
+
+    trace_first = 1;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", trace_file);
+
+    // Name the rows and keep them in track order
+    for (int track = SIM_TRACK_CALL; track <= SIM_TRACK_DEVICE; track++)
+    {
+        sim_trace_separator();
+        fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+                track, trace_track_names[track]);
+        fprintf(trace_file, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+                track, track);
+    }
+
+    return 1;
+}
+
+void sim_trace_span(sim_track_t track, const char *name, uint64_t start_ns, uint64_t duration_ns, uint16_t address, uint32_t size)
+{
+    if (trace_file == NULL)
+    {
+        return;
+    }
+
+    // Chrome trace timestamps are microseconds, keep the nanoseconds as decimals
+    sim_trace_separator();
+    fprintf(trace_file,
+            "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu.%03u,\"dur\":%llu.%03u,"
+            "\"args\":{\"address\":\"0x%04X\",\"size\":%lu}}",
+            name, (int)track,
+            (unsigned long long)(start_ns / 1000), (unsigned)(start_ns % 1000),
+            (unsigned long long)(duration_ns / 1000), (unsigned)(duration_ns % 1000),
+            address, (unsigned long)size);
+}
+
+void sim_trace_close(void)
+{
+    if (trace_file == NULL)
+    {
+        return;
+    }
+
+    fputs("\n]}\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+}
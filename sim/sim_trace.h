@@ -0,0 +1,54 @@
+/**
+ * @file sim_trace.h
+ * @brief Chrome Trace Event Writer for the Host Simulator
+ *
+ * Writes complete ("X") events in the Chrome trace JSON format, which both
+ * chrome://tracing and ui.perfetto.dev open directly. Timestamps are virtual simulator
+ * time, so a trace shows exactly how bus transfers, device write cycles, ACK polling
+ * and CPU work line up on the critical path of a save.
+ *
+ * Each track is a row in the viewer. Spans on one track may nest but must not overlap.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <stdint.h>
+
+// Rows shown in the trace viewer
+typedef enum {
+    SIM_TRACK_CALL = 1,     ///< Library calls made by the driver
+    SIM_TRACK_CPU,          ///< CPU work modelled by the simulator (CRC)
+    SIM_TRACK_BUS,          ///< I2C transfers and ACK polling
+    SIM_TRACK_DEVICE        ///< Internal write cycles of the EEPROM
+} sim_track_t;
+
+/**
+ * @brief Starts a trace file.
+ *
+ * @param path Output file, e.g. "trace.json".
+ * @return 1 on success, 0 if the file could not be created.
+ */
+uint8_t sim_trace_open(const char *path);
+
+/**
+ * @brief Adds a span to the trace. Does nothing if no trace is open.
+ *
+ * @param track Row the span is drawn on.
+ * @param name Span label.
+ * @param start_ns Start in virtual nanoseconds.
+ * @param duration_ns Duration in virtual nanoseconds.
+ * @param address EEPROM address shown in the span arguments.
+ * @param size Byte count shown in the span arguments.
+ */
+void sim_trace_span(sim_track_t track, const char *name, uint64_t start_ns, uint64_t duration_ns, uint16_t address, uint32_t size);
+
+/**
+ * @brief Finishes and closes the trace file.
+ */
+void sim_trace_close(void);
+
+#endif // SIM_TRACE_H
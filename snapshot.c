@@ -0,0 +1,68 @@
+#include "snapshot.h"
+#include <stdatomic.h>
+
+static struct_data_t snapshot_copy[2];          // Published state, readers use copy (sequence & 1)
+static atomic_uint_fast32_t snapshot_sequence;  // Odd while copy 0 is updated, even while copy 1 is
+static uint32_t snapshot_size = 0;              // Size of the state
+
+// Moves readers to the other copy. The release store keeps the previous copy's update before
+// it, the fence keeps the next copy's update after it.
+static void snapshot_advance(uint_fast32_t sequence)
+{
+    atomic_store_explicit(&snapshot_sequence, sequence, memory_order_release);
+    atomic_thread_fence(memory_order_release);
+}
+
+uint8_t snapshot_init(const uint8_t *buffer, uint32_t size)
+{
+    if (size > sizeof(snapshot_copy[0]))
+    {
+        return 0;
+    }
+
+    snapshot_size = size;
+    memcpy(&snapshot_copy[0], buffer, size);
+    memcpy(&snapshot_copy[1], buffer, size);
+    atomic_store_explicit(&snapshot_sequence, 0, memory_order_release);
+
+    return 1;
+}
+
+void snapshot_publish(const uint8_t *buffer)
+{
+    uint_fast32_t sequence = atomic_load_explicit(&snapshot_sequence, memory_order_relaxed);
+
+    snapshot_advance(sequence + 1);
+    memcpy(&snapshot_copy[0], buffer, snapshot_size);
+
+    snapshot_advance(sequence + 2);
+    memcpy(&snapshot_copy[1], buffer, snapshot_size);
+}
+
+uint8_t snapshot_save(struct_i2c_handle *i2c, uint8_t *buffer, uint8_t current_sector)
+{
+    // Without a successful snapshot_init() there is no size to save
+    if (snapshot_size == 0)
+    {
+        return current_sector;
+    }
+
+    snapshot_publish(buffer);
+
+    return eeprom_sector_write(i2c, buffer, snapshot_size, current_sector);
+}
+
+uint32_t snapshot_read(uint8_t *buffer)
+{
+    uint_fast32_t sequence;
+
+    // The copy being read is only touched once the counter has moved past `sequence`
+    do
+    {
+        sequence = atomic_load_explicit(&snapshot_sequence, memory_order_acquire);
+        memcpy(buffer, &snapshot_copy[sequence & 1], snapshot_size);
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&snapshot_sequence, memory_order_relaxed) != sequence);
+
+    return (uint32_t)(sequence / 2);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file snapshot.h
+ * @brief Lock-Free Consistent Snapshots for Concurrent Readers
+ *
+ * Under an RTOS, tasks reading the RAM copy of the state while another task updates it
+ * can see a torn record, and a mutex held across `eeprom_sector_write()` blocks them for
+ * the whole write cycle. This module publishes the state in two RAM copies guarded by a
+ * sequence counter, in the style of a latched sequence lock:
+ * - The writer bumps the counter to odd, updates copy 0, bumps it to even and updates
+ *   copy 1. Readers always read the copy the writer is not touching.
+ * - A reader copies the record and retries only if the counter moved meanwhile, which
+ *   takes a publish (two `memcpy()` of the record) to overlap the read.
+ *
+ * Readers therefore never wait on the EEPROM, and never block the writer. The record is
+ * written to the EEPROM from the writer's own buffer after publishing, so the bus time
+ * of the save is spent outside any shared state.
+ *
+ * @note There is a single writer. Tasks that save must serialize among themselves, e.g.
+ *       with the mutex they already use around `eeprom_sector_write()`. Readers may run
+ *       in any task or interrupt.
+ *
+ * Usage:
+ * - Call `snapshot_init()` after loading the state.
+ * - The writer saves with `snapshot_save()`, readers call `snapshot_read()`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "wear_levelling.h"
+
+/**
+ * @brief Publishes the initial state.
+ *
+ * @param buffer Pointer to the loaded state.
+ * @param size Size of the state structure, at most `sizeof(struct_data_t)`.
+ * @return 1 on success, 0 if `size` is too large and nothing was published.
+ */
+uint8_t snapshot_init(const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Publishes a new state to the readers without writing it to the EEPROM.
+ *
+ * @param buffer Pointer to the new state, owned by the writer.
+ */
+void snapshot_publish(const uint8_t *buffer);
+
+/**
+ * @brief Publishes a new state, then writes it to the next sector.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the new state, owned by the writer.
+ * @param current_sector Index of the currently active sector.
+ * @return The new active sector index, see `eeprom_sector_write()`.
+ */
+uint8_t snapshot_save(struct_i2c_handle *i2c, uint8_t *buffer, uint8_t current_sector);
+
+/**
+ * @brief Copies a consistent snapshot of the newest published state.
+ *
+ * @param buffer Destination buffer of the size given to `snapshot_init()`.
+ * @return Version of the snapshot, incremented by every publish.
+ */
+uint32_t snapshot_read(uint8_t *buffer);
+
+#endif // SNAPSHOT_H
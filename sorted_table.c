@@ -0,0 +1,235 @@
+#include "sorted_table.h"
+#include "record_format.h"
+
+#define TABLE_NO_BLOCK  UINT32_MAX      ///< Cache line holds no block
+
+_Static_assert(TABLE_ADDRESS + TABLE_HEADER_SIZE + TABLE_BLOCK_SIZE <= EEPROM_CAPACITY,
+               "The table needs room for its header and at least one block");
+
+// Cached block
+typedef struct {
+    uint32_t block;                     ///< Block index, TABLE_NO_BLOCK if unused
+    uint32_t used;                      ///< Tick of the last lookup served
+    uint8_t image[TABLE_BLOCK_SIZE];    ///< Block as read from the device, CRC checked
+} struct_table_cache_t;
+
+static struct_table_cache_t table_cache[TABLE_CACHE_BLOCKS];
+static uint32_t table_count = 0;        // Entries in the open table
+static uint32_t table_blocks = 0;       // Blocks in the open table
+static uint32_t table_tick = 0;         // Lookup counter driving the replacement
+
+static uint16_t table_block_address(uint32_t block)
+{
+    return (uint16_t)(TABLE_ADDRESS + TABLE_HEADER_SIZE + block * TABLE_BLOCK_SIZE);
+}
+
+static uint8_t table_block_entries(uint32_t block)
+{
+    uint32_t remaining = table_count - block * TABLE_BLOCK_ENTRIES;
+
+    return (uint8_t)((remaining < TABLE_BLOCK_ENTRIES) ? remaining : TABLE_BLOCK_ENTRIES);
+}
+
+static uint32_t table_key(const uint8_t *image, uint8_t entry)
+{
+    return le32_load(&image[entry * TABLE_ENTRY_SIZE]);
+}
+
+static void table_cache_clear(void)
+{
+    for (uint8_t i = 0; i < TABLE_CACHE_BLOCKS; i++)
+    {
+        table_cache[i].block = TABLE_NO_BLOCK;
+        table_cache[i].used = 0;
+    }
+}
+
+// Binary search within a block image
+static uint8_t table_block_find(const uint8_t *image, uint8_t entries, uint32_t key, uint8_t *value)
+{
+    uint8_t low = 0;
+    uint8_t high = entries;
+
+    while (low < high)
+    {
+        uint8_t middle = (uint8_t)(low + (high - low) / 2);
+
+        if (table_key(image, middle) < key)
+        {
+            low = (uint8_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low == entries || table_key(image, low) != key)
+    {
+        return 0;
+    }
+
+    memcpy(value, &image[low * TABLE_ENTRY_SIZE + 4], TABLE_VALUE_SIZE);
+
+    return 1;
+}
+
+uint8_t table_write(const struct_i2c_handle *i2c, const uint32_t *keys, const uint8_t *values, uint32_t count)
+{
+    uint8_t header[TABLE_HEADER_SIZE] = {0};
+    uint8_t image[TABLE_BLOCK_SIZE];
+
+    // Block addresses past the end of the device would wrap onto other data
+    if (count > TABLE_MAX_ENTRIES)
+    {
+        return 0;
+    }
+
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (keys[i] <= keys[i - 1])
+        {
+            return 0;
+        }
+    }
+
+    // Invalidate the old header first, so a table interrupted halfway is never opened
+    table_count = 0;
+    table_cache_clear();
+
+    if (eeprom_bus_write(i2c, TABLE_ADDRESS, header, sizeof(header)) != EEPROM_OK)
+    {
+        return 0;
+    }
+
+    for (uint32_t block = 0; block * TABLE_BLOCK_ENTRIES < count; block++)
+    {
+        memset(image, 0xFF, sizeof(image));
+
+        for (uint8_t entry = 0; entry < TABLE_BLOCK_ENTRIES && block * TABLE_BLOCK_ENTRIES + entry < count; entry++)
+        {
+            uint32_t index = block * TABLE_BLOCK_ENTRIES + entry;
+
+            le32_store(&image[entry * TABLE_ENTRY_SIZE], keys[index]);
+            memcpy(&image[entry * TABLE_ENTRY_SIZE + 4], &values[index * TABLE_VALUE_SIZE], TABLE_VALUE_SIZE);
+        }
+
+        record_crc_seal(image, sizeof(image));
+
+        if (eeprom_bus_write(i2c, table_block_address(block), image, sizeof(image)) != EEPROM_OK)
+        {
+            return 0;
+        }
+    }
+
+    le32_store(&header[0], count);
+    le16_store(&header[4], TABLE_BLOCK_ENTRIES);
+    le16_store(&header[6], TABLE_VALUE_SIZE);
+    record_crc_seal(header, sizeof(header));
+
+    return eeprom_bus_write(i2c, TABLE_ADDRESS, header, sizeof(header)) == EEPROM_OK;
+}
+
+uint32_t table_open(const struct_i2c_handle *i2c)
+{
+    uint8_t header[TABLE_HEADER_SIZE];
+
+    table_count = 0;
+    table_blocks = 0;
+    table_cache_clear();
+
+    if (eeprom_bus_read(i2c, TABLE_ADDRESS, header, sizeof(header)) != EEPROM_OK ||
+        !record_crc_valid(header, sizeof(header)) ||
+        le16_load(&header[4]) != TABLE_BLOCK_ENTRIES || le16_load(&header[6]) != TABLE_VALUE_SIZE ||
+        le32_load(&header[0]) > TABLE_MAX_ENTRIES)
+    {
+        return 0;
+    }
+
+    table_count = le32_load(&header[0]);
+    table_blocks = (table_count + TABLE_BLOCK_ENTRIES - 1) / TABLE_BLOCK_ENTRIES;
+
+    return table_count;
+}
+
+uint8_t table_lookup(const struct_i2c_handle *i2c, uint32_t key, uint8_t *value)
+{
+    uint8_t first[4];
+    uint32_t low = 0;
+    uint32_t high = table_blocks;       // One past the last candidate block
+    struct_table_cache_t *victim = &table_cache[0];
+
+    table_tick++;
+
+    // Serve from the cache, or use the cached blocks to narrow the search
+    for (uint8_t i = 0; i < TABLE_CACHE_BLOCKS; i++)
+    {
+        struct_table_cache_t *line = &table_cache[i];
+
+        if (line->block == TABLE_NO_BLOCK)
+        {
+            victim = line;
+            continue;
+        }
+
+        uint8_t entries = table_block_entries(line->block);
+
+        if (key < table_key(line->image, 0))
+        {
+            high = (line->block < high) ? line->block : high;
+        }
+        else if (key > table_key(line->image, entries - 1))
+        {
+            low = (line->block + 1 > low) ? line->block + 1 : low;
+        }
+        else
+        {
+            line->used = table_tick;
+            return table_block_find(line->image, entries, key, value);
+        }
+
+        if (victim->block != TABLE_NO_BLOCK && line->used < victim->used)
+        {
+            victim = line;
+        }
+    }
+
+    if (low >= high)
+    {
+        return 0;
+    }
+
+    // Last block whose first key is not above the key, reading only first keys
+    high--;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low + 1) / 2;
+
+        if (eeprom_bus_read(i2c, table_block_address(middle), first, sizeof(first)) != EEPROM_OK)
+        {
+            return 0;
+        }
+
+        if (le32_load(first) <= key)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    victim->block = TABLE_NO_BLOCK;
+
+    if (eeprom_bus_read(i2c, table_block_address(low), victim->image, TABLE_BLOCK_SIZE) != EEPROM_OK ||
+        !record_crc_valid(victim->image, TABLE_BLOCK_SIZE))
+    {
+        return 0;
+    }
+
+    victim->block = low;
+    victim->used = table_tick;
+
+    return table_block_find(victim->image, table_block_entries(low), key, value);
+}
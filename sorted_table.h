@@ -0,0 +1,77 @@
+/**
+ * @file sorted_table.h
+ * @brief Read-Optimized Sorted Table with On-Device Binary Search
+ *
+ * Large lookup tables that are written once, such as factory calibration curves, do not
+ * need to live in RAM. This module stores them on the EEPROM sorted by a 32-bit key with
+ * a fixed stride, in blocks of `TABLE_BLOCK_ENTRIES` entries protected by their own CRC.
+ *
+ * A lookup binary searches the blocks by reading only their first key, reads the one
+ * block that can hold the key, checks its CRC and searches it in RAM. The most recently
+ * used blocks are kept in a small cache, so repeated lookups of nearby keys cost no bus
+ * traffic at all, and cached blocks also narrow the search for the others.
+ *
+ * @note Configure `TABLE_ADDRESS`, `TABLE_VALUE_SIZE`, `TABLE_BLOCK_ENTRIES` and
+ *       `TABLE_CACHE_BLOCKS` in `config.h`.
+ *
+ * Usage:
+ * - At the factory, call `table_write()` once with the keys in ascending order.
+ * - In the field, call `table_open()` at boot and `table_lookup()` as needed.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef SORTED_TABLE_H
+#define SORTED_TABLE_H
+
+#include "wear_levelling.h"
+
+/**
+ * Table Memory Map:
+ * +------------------------------------------------------+
+ * | Count | Block entries | Value size | CRC16           |  -> 10 byte header
+ * +------------------------------------------------------+
+ * | Key | Value | Key | Value | ...        | CRC16       |  -> Block 0, keys ascending
+ * +------------------------------------------------------+
+ * |                        ...                           |
+ * +------------------------------------------------------+
+ */
+
+#define TABLE_HEADER_SIZE   10                                          ///< Count (4) + entries (2) + value size (2) + CRC (2)
+#define TABLE_ENTRY_SIZE    (4 + TABLE_VALUE_SIZE)                      ///< Key (4) + value
+#define TABLE_BLOCK_SIZE    (TABLE_BLOCK_ENTRIES * TABLE_ENTRY_SIZE + 2)   ///< Entries + CRC (2)
+#define TABLE_MAX_ENTRIES   ((EEPROM_CAPACITY - TABLE_ADDRESS - TABLE_HEADER_SIZE) / TABLE_BLOCK_SIZE * TABLE_BLOCK_ENTRIES)  ///< Entries fitting before the end of the device
+
+/**
+ * @brief Writes a sorted table, replacing any previous one.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param keys Keys in strictly ascending order.
+ * @param values `count` values of `TABLE_VALUE_SIZE` bytes, in key order.
+ * @param count Number of entries.
+ * @return 1 on success, 0 if the keys are not sorted, `count` exceeds `TABLE_MAX_ENTRIES`
+ *         or a write failed. The previous table is left in place unless a write failed.
+ */
+uint8_t table_write(const struct_i2c_handle *i2c, const uint32_t *keys, const uint8_t *values, uint32_t count);
+
+/**
+ * @brief Reads and checks the table header and empties the block cache.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @return Number of entries, 0 if there is no valid table for this configuration or its
+ *         count would run past the end of the device.
+ */
+uint32_t table_open(const struct_i2c_handle *i2c);
+
+/**
+ * @brief Looks up a key.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param key Key to find.
+ * @param value Buffer of `TABLE_VALUE_SIZE` bytes.
+ * @return 1 if the key was found, 0 if it is absent or its block failed its CRC.
+ */
+uint8_t table_lookup(const struct_i2c_handle *i2c, uint32_t key, uint8_t *value);
+
+#endif // SORTED_TABLE_H
@@ -0,0 +1,118 @@
+#include "tiered_storage.h"
+#include "record_format.h"
+
+static struct_data_t tier_record;               // Newest record, as saved to the FRAM
+static uint32_t tier_size = 0;                  // Size of the record
+static uint32_t tier_sequence = 0;              // Sequence of the newest FRAM slot
+static uint8_t tier_slot = 1;                   // FRAM slot holding the newest record
+static uint8_t tier_sector = SECTOR_NONE;       // Active EEPROM sector
+static uint16_t tier_pending = 0;               // FRAM saves not yet destaged to the EEPROM
+
+static uint16_t tier_slot_address(uint8_t slot)
+{
+    return (uint16_t)(TIER_FRAM_ADDRESS + slot * (tier_size + TIER_SLOT_OVERHEAD));
+}
+
+uint8_t tier_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size)
+{
+    uint8_t image[sizeof(struct_data_t) + TIER_SLOT_OVERHEAD];
+    uint8_t found = 0;
+
+    // Records are staged in `struct_data_t` buffers, a larger one cannot be tiered
+    if (size > sizeof(struct_data_t))
+    {
+        return SECTOR_ERROR;
+    }
+
+    tier_size = size;
+    tier_sector = eeprom_sector_load(i2c, buffer, size);
+
+    for (uint8_t slot = 0; slot < 2; slot++)
+    {
+        fram_read(i2c, tier_slot_address(slot), image, size + TIER_SLOT_OVERHEAD);
+
+        if (calculate_crc16(image, size + 4) != le16_load(&image[size + 4]))
+        {
+            continue;
+        }
+
+        uint32_t sequence = le32_load(&image[0]);
+        if (found && (int32_t)(sequence - tier_sequence) <= 0)
+        {
+            continue;
+        }
+
+        memcpy(&tier_record, &image[4], size);
+        tier_sequence = sequence;
+        tier_slot = slot;
+        found = 1;
+    }
+
+    if (!found)
+    {
+        memcpy(&tier_record, buffer, size);
+        tier_pending = 0;
+        return tier_sector;
+    }
+
+    // The FRAM record is never older than the EEPROM one, it only needs destaging if they differ
+    tier_pending = (memcmp(buffer, &tier_record, size) != 0) ? 1 : 0;
+    memcpy(buffer, &tier_record, size);
+
+    return tier_sector;
+}
+
+uint8_t tier_save(struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size)
+{
+    uint8_t image[sizeof(struct_data_t) + TIER_SLOT_OVERHEAD];
+
+    if (size > sizeof(struct_data_t))
+    {
+        return SECTOR_ERROR;
+    }
+
+    memcpy(&tier_record, buffer, size);
+    tier_size = size;
+
+    // Overwrite the older slot, the newer one stays valid until this write completes
+    tier_sequence++;
+    tier_slot ^= 1;
+
+    le32_store(&image[0], tier_sequence);
+    memcpy(&image[4], buffer, size);
+    le16_store(&image[size + 4], calculate_crc16(image, size + 4));
+    fram_write(i2c, tier_slot_address(tier_slot), image, size + TIER_SLOT_OVERHEAD);
+
+    if (tier_pending < UINT16_MAX)
+    {
+        tier_pending++;
+    }
+
+#if TIER_DESTAGE_INTERVAL
+    if (tier_pending >= TIER_DESTAGE_INTERVAL)
+    {
+        return tier_destage(i2c);
+    }
+#endif
+
+    return tier_sector;
+}
+
+uint8_t tier_destage(struct_i2c_handle *i2c)
+{
+    if (tier_pending == 0)
+    {
+        return tier_sector;
+    }
+
+    uint8_t sector = eeprom_sector_write(i2c, (uint8_t *)&tier_record, tier_size, tier_sector);
+
+    // An unchanged sector means the write failed, keep the record pending and retry next time
+    if (sector != tier_sector)
+    {
+        tier_sector = sector;
+        tier_pending = 0;
+    }
+
+    return tier_sector;
+}
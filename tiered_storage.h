@@ -0,0 +1,64 @@
+/**
+ * @file tiered_storage.h
+ * @brief Tiered Storage with an FRAM Front Tier
+ *
+ * On boards with a small FRAM next to the EEPROM, frequent saves go to the FRAM, which
+ * has no write cycle delay and practically no wear. The newest record is destaged to the
+ * wear-levelled EEPROM sectors every `TIER_DESTAGE_INTERVAL` saves or whenever
+ * `tier_destage()` is called, e.g. from a periodic task or before a planned shutdown.
+ *
+ * The FRAM holds two slots written alternately, so a save interrupted by a reset leaves
+ * the previous one intact. At load the newest valid FRAM slot wins, since the EEPROM only
+ * ever receives records that went through the FRAM first; without a valid FRAM slot the
+ * EEPROM record is used. The two slots are all the FRAM holds, so it never fills; the
+ * interval and explicit calls are what bound how far the EEPROM lags behind.
+ *
+ * @note Configure `TIER_FRAM_ADDRESS` and `TIER_DESTAGE_INTERVAL` and implement
+ *       `fram_write()` and `fram_read()` in `config.h`.
+ *
+ * Usage:
+ * - Call `tier_load()` instead of `eeprom_sector_load()` at boot.
+ * - Call `tier_save()` instead of `eeprom_sector_write()`.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef TIERED_STORAGE_H
+#define TIERED_STORAGE_H
+
+#include "wear_levelling.h"
+
+#define TIER_SLOT_OVERHEAD  6   ///< Sequence (4) + slot CRC (2)
+
+/**
+ * @brief Loads the newest record from the FRAM or, failing that, from the EEPROM.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the buffer where the record will be loaded.
+ * @param size Size of the record, at most `sizeof(struct_data_t)`.
+ * @return The active EEPROM sector index, or `SECTOR_ERROR` if `size` is too large and
+ *         nothing was loaded.
+ */
+uint8_t tier_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Saves a record to the FRAM and destages it when the interval is reached.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the record.
+ * @param size Size of the record, as passed to `tier_load()`.
+ * @return The active EEPROM sector index, or `SECTOR_ERROR` if `size` is too large and
+ *         nothing was saved.
+ */
+uint8_t tier_save(struct_i2c_handle *i2c, const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Writes the newest FRAM record to the EEPROM if it has not been destaged yet.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @return The active EEPROM sector index.
+ */
+uint8_t tier_destage(struct_i2c_handle *i2c);
+
+#endif // TIERED_STORAGE_H
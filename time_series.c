@@ -0,0 +1,262 @@
+#include "time_series.h"
+#include "record_format.h"
+
+static uint16_t ts_newest = TS_PAGES - 1;           // Slot of the newest page
+static uint16_t ts_sequence = UINT16_MAX;           // Sequence of the newest page
+static uint16_t ts_used = 0;                        // Pages holding samples
+static uint8_t ts_filled = TS_SAMPLES_PER_PAGE;     // Samples in the newest page
+static uint32_t ts_last = 0;                        // Timestamp of the newest sample
+
+static uint16_t ts_page_address(uint16_t slot)
+{
+    return (uint16_t)(TS_ADDRESS + slot * EEPROM_PAGE_SIZE);
+}
+
+// Slot of a page counted from the oldest one
+static uint16_t ts_page_slot(uint16_t page)
+{
+    return (uint16_t)((ts_newest + 1 + TS_PAGES - ts_used + page) % TS_PAGES);
+}
+
+// CRC of a sample, covering the sequence of its page so samples of an earlier lap do not match
+static uint16_t ts_sample_crc(uint16_t sequence, const uint8_t *sample)
+{
+    uint8_t image[2 + 4 + TS_SAMPLE_SIZE];
+
+    le16_store(&image[0], sequence);
+    memcpy(&image[2], sample, 4 + TS_SAMPLE_SIZE);
+
+    return calculate_crc16(image, sizeof(image));
+}
+
+static uint8_t ts_read_header(const struct_i2c_handle *i2c, uint16_t slot, uint16_t *sequence, uint32_t *first)
+{
+    uint8_t header[TS_HEADER_SIZE];
+
+    if (eeprom_bus_read(i2c, ts_page_address(slot), header, sizeof(header)) != EEPROM_OK ||
+        !record_crc_valid(header, sizeof(header)))
+    {
+        return 0;
+    }
+
+    *sequence = le16_load(&header[0]);
+    *first = le32_load(&header[2]);
+
+    return 1;
+}
+
+// Reads a whole page and returns the number of leading samples that belong to it
+static uint8_t ts_read_page(const struct_i2c_handle *i2c, uint16_t slot, uint16_t sequence, uint8_t *image)
+{
+    uint8_t count = 0;
+
+    if (eeprom_bus_read(i2c, ts_page_address(slot), image, EEPROM_PAGE_SIZE) != EEPROM_OK ||
+        !record_crc_valid(image, TS_HEADER_SIZE) || le16_load(&image[0]) != sequence)
+    {
+        return 0;
+    }
+
+    while (count < TS_SAMPLES_PER_PAGE)
+    {
+        const uint8_t *sample = &image[TS_HEADER_SIZE + count * TS_SAMPLE_STRIDE];
+
+        if (ts_sample_crc(sequence, sample) != le16_load(&sample[4 + TS_SAMPLE_SIZE]))
+        {
+            break;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+uint16_t ts_load(const struct_i2c_handle *i2c)
+{
+    uint8_t image[EEPROM_PAGE_SIZE];
+    uint16_t first_sequence = 0;
+    uint16_t sequence = 0;
+    uint32_t first = 0;
+
+    if (ts_read_header(i2c, 0, &first_sequence, &first))
+    {
+        // Pages up to the newest one hold consecutive sequences, see persistent_queue.c
+        uint16_t low = 0;
+        uint16_t high = TS_PAGES - 1;
+
+        while (low < high)
+        {
+            uint16_t middle = (uint16_t)(low + (high - low + 1) / 2);
+
+            if (ts_read_header(i2c, middle, &sequence, &first) && sequence == (uint16_t)(first_sequence + middle))
+            {
+                low = middle;
+            }
+            else
+            {
+                high = (uint16_t)(middle - 1);
+            }
+        }
+
+        ts_newest = low;
+        ts_sequence = (uint16_t)(first_sequence + low);
+        ts_used = (uint16_t)(low + 1);
+
+        // The ring has wrapped if the oldest page follows, possibly after a page torn while opening it
+        for (uint16_t slot = (uint16_t)(low + 1); slot <= low + 2 && slot < TS_PAGES; slot++)
+        {
+            if (ts_read_header(i2c, slot, &sequence, &first) &&
+                sequence == (uint16_t)(ts_sequence + 1 + (slot - low - 1) - TS_PAGES))
+            {
+                ts_used = (uint16_t)(TS_PAGES - (slot - low - 1));
+                break;
+            }
+        }
+    }
+    else if (ts_read_header(i2c, TS_PAGES - 1, &sequence, &first))
+    {
+        // Page 0 was torn while opening it, the ring had wrapped
+        ts_newest = TS_PAGES - 1;
+        ts_sequence = sequence;
+        ts_used = TS_PAGES - 1;
+    }
+    else
+    {
+        ts_newest = TS_PAGES - 1;
+        ts_sequence = UINT16_MAX;
+        ts_used = 0;
+        ts_filled = TS_SAMPLES_PER_PAGE;
+        return 0;
+    }
+
+    ts_filled = ts_read_page(i2c, ts_newest, ts_sequence, image);
+    ts_last = (ts_filled > 0) ? le32_load(&image[TS_HEADER_SIZE + (ts_filled - 1) * TS_SAMPLE_STRIDE]) : le32_load(&image[2]);
+
+    return ts_used;
+}
+
+uint8_t ts_append(const struct_i2c_handle *i2c, uint32_t timestamp, const uint8_t *payload)
+{
+    uint8_t image[TS_HEADER_SIZE + TS_SAMPLE_STRIDE];
+    uint8_t *sample = &image[TS_HEADER_SIZE];
+
+    if (ts_used > 0 && timestamp < ts_last)
+    {
+        return 0;
+    }
+
+    le32_store(&sample[0], timestamp);
+    memcpy(&sample[4], payload, TS_SAMPLE_SIZE);
+
+    if (ts_used == 0 || ts_filled >= TS_SAMPLES_PER_PAGE)
+    {
+        // Open the next page: header and first sample go out in one page write
+        uint16_t slot = (uint16_t)((ts_newest + 1) % TS_PAGES);
+        uint16_t sequence = (uint16_t)(ts_sequence + 1);
+
+        le16_store(&image[0], sequence);
+        le32_store(&image[2], timestamp);
+        record_crc_seal(image, TS_HEADER_SIZE);
+        le16_store(&sample[4 + TS_SAMPLE_SIZE], ts_sample_crc(sequence, sample));
+
+        if (eeprom_bus_write(i2c, ts_page_address(slot), image, sizeof(image)) != EEPROM_OK)
+        {
+            return 0;
+        }
+
+        ts_newest = slot;
+        ts_sequence = sequence;
+        ts_filled = 1;
+
+        if (ts_used < TS_PAGES)
+        {
+            ts_used++;
+        }
+    }
+    else
+    {
+        le16_store(&sample[4 + TS_SAMPLE_SIZE], ts_sample_crc(ts_sequence, sample));
+
+        if (eeprom_bus_write(i2c, ts_page_address(ts_newest) + TS_HEADER_SIZE + ts_filled * TS_SAMPLE_STRIDE,
+                             sample, TS_SAMPLE_STRIDE) != EEPROM_OK)
+        {
+            return 0;
+        }
+
+        ts_filled++;
+    }
+
+    ts_last = timestamp;
+
+    return 1;
+}
+
+// Makes sure the cursor has a sample buffered, reading the next page if needed
+static uint8_t ts_cursor_fill(const struct_i2c_handle *i2c, struct_ts_cursor_t *cursor)
+{
+    while (cursor->sample >= cursor->count)
+    {
+        if (cursor->page >= ts_used)
+        {
+            return 0;
+        }
+
+        uint16_t sequence = (uint16_t)(ts_sequence - (ts_used - 1 - cursor->page));
+
+        cursor->count = ts_read_page(i2c, ts_page_slot(cursor->page), sequence, cursor->image);
+        cursor->sample = 0;
+        cursor->page++;
+    }
+
+    return 1;
+}
+
+void ts_seek(const struct_i2c_handle *i2c, struct_ts_cursor_t *cursor, uint32_t start)
+{
+    uint16_t low = 0;
+    uint16_t high = (ts_used > 0) ? (uint16_t)(ts_used - 1) : 0;
+    uint16_t sequence = 0;
+    uint32_t first = 0;
+
+    // Last page starting before `start`, earlier pages cannot hold a matching sample. Samples
+    // equal to `start` may continue from the page before one that starts exactly at `start`.
+    while (low < high)
+    {
+        uint16_t middle = (uint16_t)(low + (high - low + 1) / 2);
+
+        if (ts_read_header(i2c, ts_page_slot(middle), &sequence, &first) && first < start)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = (uint16_t)(middle - 1);
+        }
+    }
+
+    cursor->page = low;
+    cursor->sample = 0;
+    cursor->count = 0;
+
+    while (ts_cursor_fill(i2c, cursor) &&
+           le32_load(&cursor->image[TS_HEADER_SIZE + cursor->sample * TS_SAMPLE_STRIDE]) < start)
+    {
+        cursor->sample++;
+    }
+}
+
+uint8_t ts_next(const struct_i2c_handle *i2c, struct_ts_cursor_t *cursor, uint32_t *timestamp, uint8_t *payload)
+{
+    if (!ts_cursor_fill(i2c, cursor))
+    {
+        return 0;
+    }
+
+    const uint8_t *sample = &cursor->image[TS_HEADER_SIZE + cursor->sample * TS_SAMPLE_STRIDE];
+
+    *timestamp = le32_load(&sample[0]);
+    memcpy(payload, &sample[4], TS_SAMPLE_SIZE);
+    cursor->sample++;
+
+    return 1;
+}
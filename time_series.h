@@ -0,0 +1,96 @@
+/**
+ * @file time_series.h
+ * @brief Time-Indexed Sample Storage with Range Queries
+ *
+ * Logs timestamped samples of `TS_SAMPLE_SIZE` bytes in a ring of EEPROM pages. Every
+ * page starts with a small header holding its sequence number and the timestamp of its
+ * first sample, which forms a sparse index of one timestamp per page. A range query
+ * binary searches the page headers for the first page that can hold the start time and
+ * then reads whole pages sequentially, so it costs about log2(`TS_PAGES`) header reads
+ * plus the pages holding the answer.
+ *
+ * Samples must be appended in non-decreasing timestamp order. The CRC of a sample also
+ * covers the sequence of its page, so samples left in a reused page by the previous lap
+ * of the ring are ignored without erasing the page first.
+ *
+ * @note Configure `TS_ADDRESS`, `TS_PAGES` and `TS_SAMPLE_SIZE` in `config.h`. The unit
+ *       of the timestamps is up to the application.
+ *
+ * Usage:
+ * - Call `ts_load()` once at boot.
+ * - Call `ts_append()` for every sample.
+ * - Query with `ts_seek()` to the start time, then `ts_next()` until past the end time.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include "wear_levelling.h"
+
+/**
+ * Time Series Page Layout:
+ * +---------------------------------------------+
+ * | Page sequence | First timestamp | CRC16     |  -> 8 byte header, the sparse index
+ * +---------------------------------------------+
+ * | Timestamp | Payload | CRC16                 |  -> Sample 0, written with the header
+ * +---------------------------------------------+
+ * | Timestamp | Payload | CRC16                 |  -> Sample 1
+ * +---------------------------------------------+
+ * |                    ...                      |
+ * +---------------------------------------------+
+ */
+
+#define TS_HEADER_SIZE      8                                           ///< Sequence (2) + timestamp (4) + CRC (2)
+#define TS_SAMPLE_STRIDE    (4 + TS_SAMPLE_SIZE + 2)                    ///< Timestamp (4) + payload + CRC (2)
+#define TS_SAMPLES_PER_PAGE ((EEPROM_PAGE_SIZE - TS_HEADER_SIZE) / TS_SAMPLE_STRIDE)
+
+// Position of a range query
+typedef struct {
+    uint16_t page;                      ///< Pages read so far, counted from the oldest
+    uint8_t sample;                     ///< Next sample within the buffered page
+    uint8_t count;                      ///< Valid samples in the buffered page
+    uint8_t image[EEPROM_PAGE_SIZE];    ///< Buffered page
+} struct_ts_cursor_t;
+
+/**
+ * @brief Recovers the newest page and the write position.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @return Number of pages holding samples.
+ */
+uint16_t ts_load(const struct_i2c_handle *i2c);
+
+/**
+ * @brief Appends a sample, overwriting the oldest page when the ring is full.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param timestamp Time of the sample, not earlier than the previous one.
+ * @param payload `TS_SAMPLE_SIZE` bytes to store.
+ * @return 1 on success, 0 if the timestamp is out of order or the write failed.
+ */
+uint8_t ts_append(const struct_i2c_handle *i2c, uint32_t timestamp, const uint8_t *payload);
+
+/**
+ * @brief Positions a cursor on the first sample at or after a given time.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param cursor Cursor to initialize.
+ * @param start Start of the range.
+ */
+void ts_seek(const struct_i2c_handle *i2c, struct_ts_cursor_t *cursor, uint32_t start);
+
+/**
+ * @brief Reads the sample under the cursor and advances it.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param cursor Cursor positioned by `ts_seek()`.
+ * @param timestamp Receives the time of the sample.
+ * @param payload Buffer of `TS_SAMPLE_SIZE` bytes.
+ * @return 1 if a sample was read, 0 at the end of the log.
+ */
+uint8_t ts_next(const struct_i2c_handle *i2c, struct_ts_cursor_t *cursor, uint32_t *timestamp, uint8_t *payload);
+
+#endif // TIME_SERIES_H
@@ -1,9 +1,23 @@
 #include "wear_levelling.h"
+#include "record_format.h"
+#include "latency_hist.h"
+#if SECTOR_DIFF_WRITE
+#include "record_diff.h"
+
+#define SECTOR_DATA_OPS    ((sizeof(struct_data_t) + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE + 1)  ///< Writes of one record, at most one per page
+#else
+#define SECTOR_DATA_OPS    1            ///< The record is written in one go
+#endif
+
+#define SECTOR_STATUS_BATCH 8           ///< Status bytes read per batch by a scan
 
 #define SECTOR_INACTIVE    0            ///< Sector is inactive
 #define SECTOR_ACTIVE      1            ///< Sector is active
 
-#define NUMBER_OF_SECTORS  4            ///< Total Number of Sectors to divide the read-write cycles, 4 sectors are used in this case. It can be changed based on user's requirement
+// With two sectors a run of both active has no last sector, so the newer one cannot be told apart
+_Static_assert(NUMBER_OF_SECTORS >= 3 && NUMBER_OF_SECTORS < SECTOR_ERROR, "Between 3 and 253 sectors are supported");
+_Static_assert(SECTOR_MAP_SIZE / NUMBER_OF_SECTORS >= sizeof(struct_data_t) + 2,
+               "The default sector map must hold the status byte and the record of every sector");
 
 /*
 +-------------+
@@ -19,94 +33,514 @@
 |             |
 |             |
 +-------------+
-|   Status    |
-+-------------+
-|   Sector 2  |
-|             |
-|             |
-+-------------+
-|   Status    |
-+-------------+
-|   Sector 3  |
-|             |
-|             |
+|     ...     |
 +-------------+
  */
 
-// Defining the addresses of status of the sectors
-uint16_t sector_status_address[NUMBER_OF_SECTORS] = 
+// Addresses of the status of the sectors, filled by eeprom_sector_map_init() or layout_plan()
+uint16_t sector_status_address[NUMBER_OF_SECTORS];
+
+// Addresses of the sectors, filled by eeprom_sector_map_init() or layout_plan()
+uint16_t sector_address[NUMBER_OF_SECTORS];
+
+// Set once the address tables hold a map
+static uint8_t sector_map_ready = 0;
+
+// Number of sectors in use, lowered by layout_plan() if fewer fit the device
+uint8_t sector_count = NUMBER_OF_SECTORS;
+
+// Sector still marked active after a failed deactivation, released by the next save on its device
+typedef struct {
+    const struct_i2c_handle *i2c;       ///< Device the sector belongs to, NULL if the slot is free
+    uint8_t sector;                     ///< Stale sector index
+} struct_stale_sector_t;
+
+static struct_stale_sector_t stale_sectors[SECTOR_DEVICES];
+
+void eeprom_sector_map_init(void)
 {
-    0x0000, 0x1000, 0x2000, 0x3000                  // Address of the status of the sectors. These are example values, user can change them based on the EEPROM memory map
-};
+    if (sector_map_ready)
+    {
+        return;
+    }
+
+    // With 4 sectors this is the classic example map: 0x0000, 0x1000, 0x2000, 0x3000
+    for (uint8_t i = 0; i < NUMBER_OF_SECTORS; i++)
+    {
+        sector_status_address[i] = (uint16_t)(SECTOR_MAP_ADDRESS + i * (SECTOR_MAP_SIZE / NUMBER_OF_SECTORS));
+        sector_address[i] = sector_status_address[i] + 2;
+    }
+
+    sector_map_ready = 1;
+}
+
+// Returns the stale sector of a device, SECTOR_NONE if it has none
+static uint8_t eeprom_sector_stale_get(const struct_i2c_handle *i2c)
+{
+    for (uint8_t i = 0; i < SECTOR_DEVICES; i++)
+    {
+        if (stale_sectors[i].i2c == i2c)
+        {
+            return stale_sectors[i].sector;
+        }
+    }
 
-// Defining the address of the sectors
-uint16_t sector_address[NUMBER_OF_SECTORS] =
+    return SECTOR_NONE;
+}
+
+void eeprom_sector_stale_set(const struct_i2c_handle *i2c, uint8_t sector)
 {
-    0x0002, 0x1002, 0x2002, 0x3002                  // Address of the sectors. These are example values, user can change them based on the EEPROM memory map
-};
+    struct_stale_sector_t *slot = NULL;
+
+    for (uint8_t i = 0; i < SECTOR_DEVICES; i++)
+    {
+        if (stale_sectors[i].i2c == i2c)
+        {
+            slot = &stale_sectors[i];
+            break;
+        }
+
+        if (slot == NULL && stale_sectors[i].i2c == NULL)
+        {
+            slot = &stale_sectors[i];
+        }
+    }
+
+    // Every slot holds the stale sector of another device
+    if (slot == NULL)
+    {
+        return;
+    }
+
+    slot->i2c = (sector == SECTOR_NONE) ? NULL : i2c;
+    slot->sector = sector;
+}
 
 void setting_sector_clear(const struct_i2c_handle *i2c, uint8_t sector) 
 {
     uint8_t status = SECTOR_INACTIVE;
     struct_data_t empty_sector = {0};
+    LATENCY_BEGIN();
+
+    eeprom_sector_map_init();
+
+    struct_eeprom_op_t ops[] =
+    {
+        { EEPROM_OP_WRITE, sector_status_address[sector], &status, sizeof(status) },
+        { EEPROM_OP_WRITE, sector_address[sector], (uint8_t *)&empty_sector, sizeof(empty_sector) }
+    };
 
-    eeprom_write(i2c, sector_status_address[sector], &status, sizeof(status));
-    eeprom_write(i2c, sector_address[sector], (uint8_t *)&empty_sector, sizeof(empty_sector));
+    eeprom_bus_batch(i2c, ops, sizeof(ops) / sizeof(ops[0]));
+
+    LATENCY_END(LATENCY_CLEAR);
 }
 
 void eeprom_all_sectors_clear(const struct_i2c_handle *i2c) 
 {
-    for (uint8_t i = 0; i < NUMBER_OF_SECTORS; i++) 
+    for (uint8_t i = 0; i < sector_count; i++) 
     {
-        setting_system_state_clear(i2c, i);
+        setting_sector_clear(i2c, i);
     }
 }
 
-uint8_t eeprom_sector_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size) 
+// Reads `size` bytes of a sector and checks the CRC of the record they start with. Without
+// `record_size` the record is all `size` bytes.
+static uint8_t eeprom_sector_valid(const struct_i2c_handle *i2c, uint8_t *sector, uint32_t size,
+                                   eeprom_record_size_t record_size, uint8_t index)
+{
+    if (eeprom_bus_read(i2c, sector_address[index], sector, size) != EEPROM_OK)
+    {
+        return 0;
+    }
+
+    uint32_t length = record_size ? record_size(sector) : size;
+
+    return length >= 2 && length <= size && record_crc_valid(sector, length);
+}
+
+// Checks that a sector is marked active and holds a valid record
+static uint8_t eeprom_sector_in_use(const struct_i2c_handle *i2c, uint8_t *sector, uint32_t size,
+                                    eeprom_record_size_t record_size, uint8_t index)
 {
-    struct_data_t sector = {0};
     uint8_t status = 0;
-    uint8_t active_sector = 0;
 
-    for (active_sector = 0; active_sector < NUMBER_OF_SECTORS; active_sector++) 
+    return eeprom_bus_read(i2c, sector_status_address[index], &status, sizeof(status)) == EEPROM_OK &&
+           status == SECTOR_ACTIVE && eeprom_sector_valid(i2c, sector, size, record_size, index);
+}
+
+// Reads the status bytes of up to SECTOR_STATUS_BATCH sectors from `first` as one batch. The
+// status bytes are spread over the device, so they cannot come from a single bulk read, but
+// a batch hands them to the bus in one go, e.g. as one chained DMA transfer. Returns the
+// number of status bytes read.
+static uint8_t eeprom_sector_status_batch(const struct_i2c_handle *i2c, uint8_t first, uint8_t count, uint8_t *statuses)
+{
+    struct_eeprom_op_t ops[SECTOR_STATUS_BATCH];
+
+    if (count > SECTOR_STATUS_BATCH)
+    {
+        count = SECTOR_STATUS_BATCH;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
     {
-        eeprom_read(i2c, sector_status_address[active_sector], &status, sizeof(status));
+        ops[i] = (struct_eeprom_op_t){ EEPROM_OP_READ, sector_status_address[(first + i) % sector_count], &statuses[i], 1 };
+    }
+
+    return eeprom_bus_batch(i2c, ops, count);
+}
 
-        if (status == SECTOR_ACTIVE) 
+// Scans `count` sectors starting at `first` for an active one with a valid CRC, which is left
+// in `sector`. `scratch` is a second buffer of `size` bytes for its neighbours. `blank` is set
+// if every status byte inspected still holds the erased value. Sectors that cannot be read are
+// skipped and counted in the bus statistics.
+static uint8_t eeprom_sector_scan(const struct_i2c_handle *i2c, uint8_t *sector, uint8_t *scratch, uint32_t size,
+                                  eeprom_record_size_t record_size, uint8_t first, uint8_t count, uint8_t *blank)
+{
+    uint8_t statuses[SECTOR_STATUS_BATCH];
+    uint8_t fetched = 0;
+    uint8_t status = 0;
+
+    eeprom_sector_map_init();
+    *blank = 1;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t active_sector = (first + i) % sector_count;
+        uint8_t slot = i % SECTOR_STATUS_BATCH;
+
+        if (slot == 0)
         {
-            eeprom_read(i2c, sector_address[active_sector], (uint8_t *)&sector, size);
-            if (calculate_crc16((uint8_t *)&sector, size - 2) == sector.crc) 
+            fetched = eeprom_sector_status_batch(i2c, active_sector, count - i, statuses);
+        }
+
+        // A status the batch could not read is tried once more on its own
+        if (slot < fetched)
+        {
+            status = statuses[slot];
+        }
+        else if (eeprom_bus_read(i2c, sector_status_address[active_sector], &status, sizeof(status)) != EEPROM_OK)
+        {
+            *blank = 0;
+            continue;
+        }
+
+        if (status != EEPROM_BLANK_VALUE)
+        {
+            *blank = 0;
+        }
+
+        if (status == SECTOR_ACTIVE && eeprom_sector_valid(i2c, sector, size, record_size, active_sector))
+        {
+            // A save whose deactivation failed leaves a run of active neighbours, the last one is newest
+            uint8_t first_active = active_sector;
+            uint8_t run = 1;
+
+            while (run < sector_count)
             {
-                memcpy(buffer, &sector, size);
-                return active_sector;
+                uint8_t previous = (first_active + sector_count - 1) % sector_count;
+
+                if (!eeprom_sector_in_use(i2c, scratch, size, record_size, previous))
+                {
+                    break;
+                }
+
+                first_active = previous;
+                run++;
             }
+
+            while (run < sector_count)
+            {
+                uint8_t next_sector = (active_sector + 1) % sector_count;
+
+                if (!eeprom_sector_in_use(i2c, scratch, size, record_size, next_sector))
+                {
+                    break;
+                }
+
+                memcpy(sector, scratch, size);
+                active_sector = next_sector;
+                run++;
+            }
+
+            eeprom_sector_stale_set(i2c, (active_sector != first_active) ? first_active : SECTOR_NONE);
+
+            return active_sector;
         }
     }
 
+    return SECTOR_NONE;
+}
+
+uint8_t eeprom_sector_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size) 
+{
+    struct_data_t sector = {0};
+    struct_data_t scratch = {0};
+    uint8_t status = 0;
+    uint8_t blank = 0;
+    uint32_t failures = eeprom_stats_get()->failures;
+    LATENCY_BEGIN();
+
+    // Records are scanned in `struct_data_t` buffers, a larger one cannot be loaded
+    if (size > sizeof(struct_data_t))
+    {
+        LATENCY_END(LATENCY_LOAD);
+        return SECTOR_ERROR;
+    }
+
+    uint8_t active_sector = eeprom_sector_scan(i2c, (uint8_t *)&sector, (uint8_t *)&scratch, size, NULL, 0, sector_count, &blank);
+
+    if (active_sector != SECTOR_NONE)
+    {
+        memcpy(buffer, &sector, size);
+        LATENCY_END(LATENCY_LOAD);
+        return active_sector;
+    }
+
+    // Never wipe the device because of a bus error, the data may well be intact
+    if (eeprom_stats_get()->failures != failures)
+    {
+        LATENCY_END(LATENCY_LOAD);
+        return SECTOR_ERROR;
+    }
+
     eeprom_all_sectors_clear(i2c);
 
     // Initialize the first sector if no valid sector is found
     status = SECTOR_ACTIVE;
-    eeprom_write(i2c, sector_status_address[0], &status, sizeof(status));
-    eeprom_write(i2c, sector_address[0], &sector, size);                     // Write the buffer to the first sector, User can use initial state to write to the first sector
+    eeprom_bus_write(i2c, sector_status_address[0], &status, sizeof(status));
+    eeprom_bus_write(i2c, sector_address[0], (uint8_t *)&sector, size);                 // Write the buffer to the first sector, User can use initial state to write to the first sector
+
+    LATENCY_END(LATENCY_LOAD);
 
     return 0; // Default to first sector
 }
 
-uint8_t eeprom_sector_write(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector) 
+uint8_t eeprom_sector_load_from(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t first_sector, uint8_t count)
 {
-    uint8_t status = SECTOR_INACTIVE;
+    struct_data_t sector = {0};
+    struct_data_t scratch = {0};
+    uint8_t blank = 0;
+    LATENCY_BEGIN();
 
-    // Deactivate current sector
-    eeprom_write(i2c, sector_status_address[current_sector], &status, sizeof(status));
+    if (size > sizeof(struct_data_t))
+    {
+        LATENCY_END(LATENCY_LOAD);
+        return SECTOR_ERROR;
+    }
+
+    uint8_t active_sector = eeprom_sector_scan(i2c, (uint8_t *)&sector, (uint8_t *)&scratch, size, NULL, first_sector, count, &blank);
+
+    if (active_sector != SECTOR_NONE)
+    {
+        memcpy(buffer, &sector, size);
+    }
+
+    LATENCY_END(LATENCY_LOAD);
+
+    return active_sector;
+}
+
+uint8_t eeprom_sector_load_defaults(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, const uint8_t *defaults)
+{
+    struct_data_t sector = {0};
+    struct_data_t scratch = {0};
+    uint8_t status = 0;
+    uint8_t blank = 0;
+    uint32_t failures = eeprom_stats_get()->failures;
+    LATENCY_BEGIN();
+
+    // Records are scanned in `struct_data_t` buffers, a larger one cannot be loaded
+    if (size > sizeof(struct_data_t))
+    {
+        LATENCY_END(LATENCY_LOAD);
+        return SECTOR_ERROR;
+    }
+
+    uint8_t active_sector = eeprom_sector_scan(i2c, (uint8_t *)&sector, (uint8_t *)&scratch, size, NULL, 0, sector_count, &blank);
+
+    if (active_sector != SECTOR_NONE)
+    {
+        memcpy(buffer, &sector, size);
+        LATENCY_END(LATENCY_LOAD);
+        return active_sector;
+    }
+
+    memcpy(buffer, defaults, size);
+
+    // A blank device stays untouched until the first real save, and so does one we failed to read
+    if (blank || eeprom_stats_get()->failures != failures)
+    {
+        LATENCY_END(LATENCY_LOAD);
+        return blank ? SECTOR_NONE : SECTOR_ERROR;
+    }
+
+    // Corrupted device, recover with the defaults instead of the last sector read
+    eeprom_all_sectors_clear(i2c);
 
-    // Activate next sector
-    current_sector = (current_sector + 1) % NUMBER_OF_SECTORS;
     status = SECTOR_ACTIVE;
-    eeprom_write(i2c, sector_status_address[current_sector], &status, sizeof(status));
+    eeprom_bus_write(i2c, sector_status_address[0], &status, sizeof(status));
+    eeprom_bus_write(i2c, sector_address[0], defaults, size);
+
+    LATENCY_END(LATENCY_LOAD);
+
+    return 0;
+}
+
+uint8_t eeprom_sector_find(const struct_i2c_handle *i2c, uint8_t *image, uint8_t *scratch, uint32_t size, eeprom_record_size_t record_size)
+{
+    uint8_t blank = 0;
+    uint32_t failures = eeprom_stats_get()->failures;
+    LATENCY_BEGIN();
+
+    uint8_t active_sector = eeprom_sector_scan(i2c, image, scratch, size, record_size, 0, sector_count, &blank);
+
+    if (active_sector == SECTOR_NONE && eeprom_stats_get()->failures != failures)
+    {
+        active_sector = SECTOR_ERROR;
+    }
+
+    LATENCY_END(LATENCY_LOAD);
+
+    return active_sector;
+}
+
+#if SECTOR_DIFF_WRITE
+// Adds the writes of the record to `ops` and returns their number. The sector still holds the
+// record saved `sector_count` saves ago, so only the pages that changed since then are rewritten.
+static uint8_t eeprom_sector_data_ops(const struct_i2c_handle *i2c, struct_eeprom_op_t *ops, uint8_t *buffer, uint32_t size, uint8_t sector)
+{
+    struct_data_t previous;
+    uint8_t bitmap[RECORD_DIFF_BITMAP_SIZE(sizeof(struct_data_t))];
+    uint16_t address = sector_address[sector];
+    uint32_t start = 0;
+    uint8_t count = 0;
+
+    // Without the old contents every page is written, as is a record too large to compare
+    if (size > sizeof(previous) || eeprom_bus_read(i2c, address, (uint8_t *)&previous, size) != EEPROM_OK)
+    {
+        ops[0] = (struct_eeprom_op_t){ EEPROM_OP_WRITE, address, buffer, size };
+        return 1;
+    }
+
+    record_diff_pages(buffer, (const uint8_t *)&previous, size, address, bitmap);
+
+    for (uint32_t page = 0; start < size; page++)
+    {
+        uint32_t end = start + EEPROM_PAGE_SIZE - ((address + start) % EEPROM_PAGE_SIZE);
+        if (end > size)
+        {
+            end = size;
+        }
+
+        if (bitmap[page / 8] & (1u << (page % 8)))
+        {
+            // Neighbouring dirty pages go out as one write, eeprom_write() splits it at the pages
+            if (count > 0 && ops[count - 1].address + ops[count - 1].size == address + start)
+            {
+                ops[count - 1].size += end - start;
+            }
+            else
+            {
+                ops[count++] = (struct_eeprom_op_t){ EEPROM_OP_WRITE, (uint16_t)(address + start), &buffer[start], end - start };
+            }
+        }
+
+        start = end;
+    }
+
+    return count;
+}
+#endif
+
+// Moves the record to the next sector, see eeprom_sector_write()
+static uint8_t eeprom_sector_rotate(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector)
+{
+    uint8_t status = SECTOR_INACTIVE;
+    uint8_t next_sector = (current_sector == SECTOR_NONE) ? 0 : (current_sector + 1) % sector_count;
+    uint8_t stale = eeprom_sector_stale_get(i2c);
+
+    // After a failed load the active sector is unknown, writing sector 0 could leave two active
+    if (current_sector == SECTOR_ERROR)
+    {
+        return current_sector;
+    }
+
+    eeprom_sector_map_init();
+
+    // Release a sector a previous save failed to deactivate before moving on, so there are never
+    // more than two active sectors and the scan can always tell which one is newer
+    if (stale != SECTOR_NONE)
+    {
+        if (eeprom_bus_write(i2c, sector_status_address[stale], &status, sizeof(status)) != EEPROM_OK)
+        {
+            return current_sector;
+        }
+
+        eeprom_sector_stale_set(i2c, SECTOR_NONE);
+    }
+
+    // A sector left active with a bad record is invisible to the scan. Release it before
+    // reusing it, or the new data would make it look like the newest sector.
+    if (eeprom_bus_read(i2c, sector_status_address[next_sector], &status, sizeof(status)) != EEPROM_OK)
+    {
+        return current_sector;
+    }
+
+    if (status == SECTOR_ACTIVE && next_sector != current_sector)
+    {
+        status = SECTOR_INACTIVE;
+        if (eeprom_bus_write(i2c, sector_status_address[next_sector], &status, sizeof(status)) != EEPROM_OK)
+        {
+            return current_sector;
+        }
+    }
+
+    // The new sector is complete and active before the current one is released, so a failed
+    // transfer leaves the current sector in place instead of a half-written slot. The rest of
+    // the save is known now, so it is issued as one batch ending with the last write cycle.
+    uint8_t active = SECTOR_ACTIVE;
+    uint8_t release = (current_sector != SECTOR_NONE && current_sector != next_sector);
+    struct_eeprom_op_t ops[SECTOR_DATA_OPS + 3];
+#if SECTOR_DIFF_WRITE
+    uint8_t data = eeprom_sector_data_ops(i2c, ops, buffer, size, next_sector);
+#else
+    uint8_t data = 1;
+
+    ops[0] = (struct_eeprom_op_t){ EEPROM_OP_WRITE, sector_address[next_sector], buffer, size };
+#endif
+    uint8_t count = data;
+
+    ops[count++] = (struct_eeprom_op_t){ EEPROM_OP_WRITE, sector_status_address[next_sector], &active, sizeof(active) };
+    if (release)
+    {
+        status = SECTOR_INACTIVE;
+        ops[count++] = (struct_eeprom_op_t){ EEPROM_OP_WRITE, sector_status_address[current_sector], &status, sizeof(status) };
+    }
+    ops[count] = (struct_eeprom_op_t){ EEPROM_OP_POLL, ops[count - 1].address, NULL, 0 };
+    count++;
+
+    uint8_t done = eeprom_bus_batch(i2c, ops, count);
+
+    if (done < data + 1)
+    {
+        return current_sector;
+    }
+
+    // Deactivating the current sector failed, both stay active and the scan picks the later one
+    if (release && done < data + 2)
+    {
+        eeprom_sector_stale_set(i2c, current_sector);
+    }
+
+    return next_sector;
+}
+
+uint8_t eeprom_sector_write(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector) 
+{
+    LATENCY_BEGIN();
+    uint8_t sector = eeprom_sector_rotate(i2c, buffer, size, current_sector);
 
-    // Write new state to active sector
-    eeprom_write(i2c, sector_address[current_sector], buffer, size);
+    LATENCY_END(LATENCY_SAVE);
 
-    return current_sector;
+    return sector;
 }
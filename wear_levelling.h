@@ -9,7 +9,7 @@
  * @note Ensure to configure `config.h` for platform-specific settings.
  *
  * Features:
- * - Supports up to `NUMBER_OF_SECTORS` for wear leveling (default: 4).
+ * - Supports up to `NUMBER_OF_SECTORS` for wear leveling (default: 4, at least 3), `sector_count` in use.
  * - Automatic CRC16-based data integrity check.
  * - Cyclic sector switching for balanced wear distribution.
  * - Supports initialization and recovery from invalid sectors.
@@ -27,17 +27,17 @@
  #define WEAR_LEVELLING_H
  
  #include "config.h"
+ #include "eeprom_bus.h"
  #include <string.h>
  
  // Sector status definitions
  #define SECTOR_INACTIVE    0    ///< Sector is inactive
  #define SECTOR_ACTIVE      1    ///< Sector is active
- 
- // Number of EEPROM sectors for wear leveling (modifiable)
- #define NUMBER_OF_SECTORS  4    ///< Total number of EEPROM sectors
+ #define SECTOR_NONE        0xFF ///< No sector has been written yet (blank device)
+ #define SECTOR_ERROR       0xFE ///< A load failed (bus error, record larger than `struct_data_t`), the device state is unknown
  
  /**
-  * EEPROM Memory Map:
+  * Default EEPROM Memory Map, `SECTOR_MAP_SIZE / NUMBER_OF_SECTORS` bytes per sector:
   * +-------------+
   * |   Status    |  -> Each sector has a status byte (active/inactive)
   * +-------------+
@@ -61,13 +61,28 @@
   * +-------------+
   */
  
+ // Sector memory map, defined in wear_levelling.c and filled by eeprom_sector_map_init() or layout_plan()
+ extern uint16_t sector_status_address[NUMBER_OF_SECTORS];   ///< Address of the status byte of each sector
+ extern uint16_t sector_address[NUMBER_OF_SECTORS];          ///< Address of the record of each sector
+ extern uint8_t sector_count;                                ///< Sectors in use, at most NUMBER_OF_SECTORS
+ 
+ /**
+  * @brief Fills the default sector map unless a map was already set.
+  *
+  * Spreads `NUMBER_OF_SECTORS` sectors evenly over `SECTOR_MAP_SIZE` bytes from
+  * `SECTOR_MAP_ADDRESS`, each one a status byte followed by the record 2 bytes later.
+  * Every load, save and clear calls it, so it only needs to be called directly before
+  * reading the address tables without any of them.
+  */
+ void eeprom_sector_map_init(void);
+ 
  /**
   * @brief Clears a specific EEPROM sector.
   *
   * Marks the specified sector as inactive and erases its contents.
   *
   * @param i2c Pointer to the I2C handle structure.
-  * @param sector Sector index (0 to NUMBER_OF_SECTORS-1).
+  * @param sector Sector index (0 to sector_count-1).
   */
  void setting_sector_clear(const struct_i2c_handle *i2c, uint8_t sector);
  
@@ -84,19 +99,99 @@
   * @brief Loads the most recent valid state from EEPROM.
   *
   * Scans all sectors for an active one with a valid CRC. If no valid sector is found,
-  * it initializes the first sector with the provided buffer.
+  * it initializes the first sector with the provided buffer. If the scan hit a bus
+  * error, nothing is written, the buffer is left as it is and `SECTOR_ERROR` is returned
+  * instead. `eeprom_sector_write()` refuses to save from `SECTOR_ERROR`, since the active
+  * sector is unknown; load again once the bus has recovered. `size` may not exceed
+  * `sizeof(struct_data_t)`, the buffer the sectors are scanned in, or `SECTOR_ERROR` is
+  * returned as well.
   *
   * @param i2c Pointer to the I2C handle structure.
   * @param buffer Pointer to the buffer where the state will be loaded.
   * @param size Size of the state structure.
-  * @return The active sector index (0 to NUMBER_OF_SECTORS-1).
+  * @return The active sector index (0 to sector_count-1), or `SECTOR_ERROR` on a bus error.
   */
  uint8_t eeprom_sector_load(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size);
  
+ /**
+  * @brief Loads a valid state from a bounded window of sectors.
+  *
+  * Scans `count` sectors starting at `first_sector`, wrapping around the last sector.
+  * Unlike `eeprom_sector_load()` nothing is written if no valid sector is found.
+  *
+  * @param i2c Pointer to the I2C handle structure.
+  * @param buffer Pointer to the buffer where the state will be loaded.
+  * @param size Size of the state structure.
+  * @param first_sector Sector index to start scanning at.
+  * @param count Maximum number of sectors to inspect.
+  * @return The active sector index, `SECTOR_NONE` if none was found in the window, or
+  *         `SECTOR_ERROR` if `size` exceeds `sizeof(struct_data_t)`.
+  */
+ uint8_t eeprom_sector_load_from(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t first_sector, uint8_t count);
+ 
+ /**
+  * @brief Loads the most recent valid state, falling back to caller-supplied defaults.
+  *
+  * On a blank device (every status byte still erased) the defaults are copied into the
+  * buffer and nothing is written, so first boot costs only the status reads of a normal
+  * boot. The first `eeprom_sector_write()` with `SECTOR_NONE` then writes sector 0. The
+  * status bytes are spread over the device and cannot be fetched with one bulk read;
+  * every scan reads them in batches of 8 through `eeprom_bus_batch()`, which a
+  * `eeprom_submit_batch()` hook can chain into a single transfer.
+  * A corrupted, non-blank device is recovered as in `eeprom_sector_load()` but with the
+  * defaults written to the first sector. A scan that hit a bus error also yields the
+  * defaults, but returns `SECTOR_ERROR` as `eeprom_sector_load()` does.
+  *
+  * @param i2c Pointer to the I2C handle structure.
+  * @param buffer Pointer to the buffer where the state will be loaded.
+  * @param size Size of the state structure.
+  * @param defaults Default state, e.g. a const in flash, with a valid CRC.
+  * @return The active sector index, `SECTOR_NONE` if the device is blank, or `SECTOR_ERROR`.
+  */
+ uint8_t eeprom_sector_load_defaults(const struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, const uint8_t *defaults);
+ 
+ /**
+  * @brief Records a sector left active besides the current one on a device.
+  *
+  * The next `eeprom_sector_write()` through the same handle releases it first, so a device
+  * never has more than two active sectors. Loads and saves call this themselves; it is only
+  * needed by loaders that pick the active sector on their own, such as `eeprom_multi_load()`.
+  * Each device is identified by its handle, and up to `SECTOR_DEVICES` devices can have a
+  * stale sector at the same time.
+  *
+  * @param i2c Pointer to the I2C handle structure of the device.
+  * @param sector Stale sector index, or `SECTOR_NONE` to forget it.
+  */
+ void eeprom_sector_stale_set(const struct_i2c_handle *i2c, uint8_t sector);
+ 
+ /// Returns the length of the record an image starts with, or 0 if it holds no known record
+ typedef uint32_t (*eeprom_record_size_t)(const uint8_t *image);
+ 
+ /**
+  * @brief Finds the most recent valid record whose length is stored in the record itself.
+  *
+  * Runs the same scan as `eeprom_sector_load()`, including the handling of a run of active
+  * sectors left by a failed deactivation, for records such as versioned ones whose length
+  * is only known once read. Nothing is written.
+  *
+  * @param i2c Pointer to the I2C handle structure.
+  * @param image Buffer of `size` bytes, holds the record found.
+  * @param scratch Second buffer of `size` bytes used while scanning.
+  * @param size Size of the largest record, read from every candidate sector.
+  * @param record_size Returns the length of the record in an image, CRC included.
+  * @return The active sector index, `SECTOR_NONE` if no valid record was found, or
+  *         `SECTOR_ERROR` if the scan hit a bus error.
+  */
+ uint8_t eeprom_sector_find(const struct_i2c_handle *i2c, uint8_t *image, uint8_t *scratch, uint32_t size, eeprom_record_size_t record_size);
+ 
  /**
   * @brief Writes a new state to the next sector using wear-leveling.
   *
-  * Marks the current sector as inactive and writes the new state to the next sector.
+  * Writes the new state to the next sector, activates it and then marks the current sector
+  * as inactive. If `current_sector` is `SECTOR_NONE` the state is written to sector 0.
+  * If a transfer fails, `current_sector` is returned unchanged and still holds the previous
+  * state; see `eeprom_last_error()`. Nothing is written if `current_sector` is `SECTOR_ERROR`.
+  * Records larger than `sizeof(struct_data_t)` are loaded back with `eeprom_sector_find()`.
   *
   * @param i2c Pointer to the I2C handle structure.
   * @param buffer Pointer to the data to be written.
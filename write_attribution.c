@@ -0,0 +1,102 @@
+#include "write_attribution.h"
+#include "record_format.h"
+
+static struct_attribution_t attribution[ATTRIBUTION_TAGS];
+static uint16_t attribution_sequence = 0;       // Sequence of the newest slot
+static uint8_t attribution_slot = 1;            // Slot holding the newest counters
+static uint8_t attribution_pending = 0;         // Tagged saves since the counters were persisted
+
+// Write cycles of a record write: the pages it spans plus activating and releasing a status byte
+static uint32_t attribution_cycles(uint8_t sector, uint32_t size)
+{
+    uint16_t first = sector_address[sector];
+    uint16_t last = (uint16_t)(first + size - 1);
+
+    return (uint32_t)(last / EEPROM_PAGE_SIZE - first / EEPROM_PAGE_SIZE + 1) + 2;
+}
+
+void attribution_load(const struct_i2c_handle *i2c)
+{
+    uint8_t image[ATTRIBUTION_SLOT_SIZE];
+    uint8_t found = 0;
+
+    for (uint8_t slot = 0; slot < 2; slot++)
+    {
+        if (eeprom_bus_read(i2c, ATTRIBUTION_ADDRESS + slot * ATTRIBUTION_SLOT_SIZE, image, sizeof(image)) != EEPROM_OK ||
+            !record_crc_valid(image, sizeof(image)))
+        {
+            continue;
+        }
+
+        uint16_t sequence = le16_load(&image[0]);
+        if (found && (int16_t)(sequence - attribution_sequence) <= 0)
+        {
+            continue;
+        }
+
+        for (uint8_t tag = 0; tag < ATTRIBUTION_TAGS; tag++)
+        {
+            const uint8_t *counters = &image[2 + tag * 12];
+
+            attribution[tag].saves = le32_load(&counters[0]);
+            attribution[tag].bytes = le32_load(&counters[4]);
+            attribution[tag].cycles = le32_load(&counters[8]);
+        }
+
+        attribution_sequence = sequence;
+        attribution_slot = slot;
+        found = 1;
+    }
+}
+
+void attribution_flush(const struct_i2c_handle *i2c)
+{
+    uint8_t image[ATTRIBUTION_SLOT_SIZE];
+    uint8_t slot = attribution_slot ^ 1;
+
+    le16_store(&image[0], (uint16_t)(attribution_sequence + 1));
+
+    for (uint8_t tag = 0; tag < ATTRIBUTION_TAGS; tag++)
+    {
+        uint8_t *counters = &image[2 + tag * 12];
+
+        le32_store(&counters[0], attribution[tag].saves);
+        le32_store(&counters[4], attribution[tag].bytes);
+        le32_store(&counters[8], attribution[tag].cycles);
+    }
+
+    record_crc_seal(image, sizeof(image));
+
+    // Only move on once the slot is written, so the older slot always stays valid
+    if (eeprom_bus_write(i2c, ATTRIBUTION_ADDRESS + slot * ATTRIBUTION_SLOT_SIZE, image, sizeof(image)) == EEPROM_OK)
+    {
+        attribution_sequence++;
+        attribution_slot = slot;
+        attribution_pending = 0;
+    }
+}
+
+uint8_t eeprom_sector_write_tagged(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector, uint8_t tag)
+{
+    uint8_t next_sector = (current_sector == SECTOR_NONE) ? 0 : (current_sector + 1) % sector_count;
+    struct_attribution_t *counters = &attribution[(tag < ATTRIBUTION_TAGS) ? tag : ATTRIBUTION_TAGS - 1];
+
+    // A failed save may still have worn the device, so every request is charged
+    counters->saves++;
+    counters->bytes += size;
+    counters->cycles += attribution_cycles(next_sector, size);
+
+    current_sector = eeprom_sector_write(i2c, buffer, size, current_sector);
+
+    if (++attribution_pending >= ATTRIBUTION_INTERVAL)
+    {
+        attribution_flush(i2c);
+    }
+
+    return current_sector;
+}
+
+const struct_attribution_t *attribution_get(uint8_t tag)
+{
+    return &attribution[(tag < ATTRIBUTION_TAGS) ? tag : ATTRIBUTION_TAGS - 1];
+}
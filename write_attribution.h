@@ -0,0 +1,70 @@
+/**
+ * @file write_attribution.h
+ * @brief Per-Caller Write Attribution
+ *
+ * When several modules save through the library, the one wearing the EEPROM out is hard
+ * to find. Saves made through `eeprom_sector_write_tagged()` carry a small caller tag and
+ * are counted per tag: number of saves, bytes written and device write cycles (the pages
+ * spanned by the record plus the status updates). The counters are persisted every
+ * `ATTRIBUTION_INTERVAL` tagged saves in two alternating slots, so they survive resets
+ * and can be read back from returned boards.
+ *
+ * @note Configure `ATTRIBUTION_ADDRESS`, `ATTRIBUTION_TAGS` and `ATTRIBUTION_INTERVAL`
+ *       in `config.h`.
+ *
+ * Usage:
+ * - Call `attribution_load()` once at boot.
+ * - Save with `eeprom_sector_write_tagged()` and a tag per calling module.
+ *
+ * @author Qazi Mashood
+ * @date March 2025
+ */
+
+#ifndef WRITE_ATTRIBUTION_H
+#define WRITE_ATTRIBUTION_H
+
+#include "wear_levelling.h"
+
+#define ATTRIBUTION_SLOT_SIZE   (2 + ATTRIBUTION_TAGS * 12 + 2)    ///< Sequence + counters + CRC
+
+// Counters of one caller tag
+typedef struct {
+    uint32_t saves;         ///< Saves requested
+    uint32_t bytes;         ///< Record bytes written
+    uint32_t cycles;        ///< Device write cycles caused
+} struct_attribution_t;
+
+/**
+ * @brief Restores the counters from the newest valid slot.
+ *
+ * Counters start at zero if no valid slot is found.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ */
+void attribution_load(const struct_i2c_handle *i2c);
+
+/**
+ * @brief Writes the data using wear-leveling and charges the write to a caller tag.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ * @param buffer Pointer to the data buffer to write.
+ * @param size Size of the data buffer.
+ * @param current_sector Index of the currently active sector.
+ * @param tag Caller tag, below `ATTRIBUTION_TAGS`.
+ * @return The new active sector index.
+ */
+uint8_t eeprom_sector_write_tagged(struct_i2c_handle *i2c, uint8_t *buffer, uint32_t size, uint8_t current_sector, uint8_t tag);
+
+/**
+ * @brief Returns the counters of a caller tag.
+ */
+const struct_attribution_t *attribution_get(uint8_t tag);
+
+/**
+ * @brief Persists the counters now, e.g. before a planned shutdown.
+ *
+ * @param i2c Pointer to the I2C handle structure.
+ */
+void attribution_flush(const struct_i2c_handle *i2c);
+
+#endif // WRITE_ATTRIBUTION_H